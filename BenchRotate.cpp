@@ -1,12 +1,71 @@
 
 #include <random>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <functional>
 #include <benchmark/benchmark.h>
 
 #include "BitArray.hpp"
 #include "StaticBitArray.hpp"
+#include "CrossCorrelation.hpp"
+#include "BitMatrix.hpp"
+#include "Population.hpp"
+#include "Coincidence.hpp"
+#include "MaskCache.hpp"
+#include "Gram.hpp"
 
 using block_type = uint64_t;
 
+// the number of heap allocations through the global operator new, the
+//  workspace benchmarks report it per iteration; every form of new and
+//  delete is replaced, so each pointer is released by the free of the
+//  allocation function which returned it
+std::atomic<size_t> num_allocations{0};
+
+void *counted_alloc(size_t size, size_t alignment) noexcept
+{
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (alignment <= alignof(std::max_align_t))
+    return std::malloc(size ? size : 1);
+
+  // aligned_alloc wants a size multiple of the alignment
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void *counted_new(size_t size, size_t alignment)
+{
+  if (void *p = counted_alloc(size, alignment))
+    return p;
+
+  throw std::bad_alloc();
+}
+
+void *operator new  (size_t size)                                                       { return counted_new(size, 0); }
+void *operator new[](size_t size)                                                       { return counted_new(size, 0); }
+void *operator new  (size_t size, std::align_val_t al)                                  { return counted_new(size, size_t(al)); }
+void *operator new[](size_t size, std::align_val_t al)                                  { return counted_new(size, size_t(al)); }
+void *operator new  (size_t size, std::nothrow_t const &) noexcept                      { return counted_alloc(size, 0); }
+void *operator new[](size_t size, std::nothrow_t const &) noexcept                      { return counted_alloc(size, 0); }
+void *operator new  (size_t size, std::align_val_t al, std::nothrow_t const &) noexcept { return counted_alloc(size, size_t(al)); }
+void *operator new[](size_t size, std::align_val_t al, std::nothrow_t const &) noexcept { return counted_alloc(size, size_t(al)); }
+
+void operator delete  (void *p) noexcept                                                { std::free(p); }
+void operator delete[](void *p) noexcept                                                { std::free(p); }
+void operator delete  (void *p, size_t) noexcept                                        { std::free(p); }
+void operator delete[](void *p, size_t) noexcept                                        { std::free(p); }
+void operator delete  (void *p, std::align_val_t) noexcept                              { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept                              { std::free(p); }
+void operator delete  (void *p, size_t, std::align_val_t) noexcept                      { std::free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept                      { std::free(p); }
+void operator delete  (void *p, std::nothrow_t const &) noexcept                        { std::free(p); }
+void operator delete[](void *p, std::nothrow_t const &) noexcept                        { std::free(p); }
+void operator delete  (void *p, std::align_val_t, std::nothrow_t const &) noexcept      { std::free(p); }
+void operator delete[](void *p, std::align_val_t, std::nothrow_t const &) noexcept      { std::free(p); }
+
 std::random_device rd;             // Will be used to obtain a seed for the random number engine
 std::mt19937       gen(rd());  // Standard mersenne_twister_engine seeded with rd()
 
@@ -64,58 +123,1251 @@ static void BM_RotateRight(benchmark::State& state)
 }
 BENCHMARK(BM_RotateRight);
 
+// Benchmark the vectorized rotate, the argument is the simd level
+//  (0: scalar, 1: AVX2, 2: AVX-512) clamped to what the cpu supports
+static void BM_RotateSimd(benchmark::State& state)
+{
+  auto level = nlg::kernels::clamp_simd_level(static_cast<nlg::kernels::simd_level>(state.range(0)));
 
-// Benchmarks with static
+  for (auto _: state)
+  {
+    for (int j = 1; j < num_bits; j++)
+    {
+      nlg::BitArray<block_type> bitarr_r(num_bits);
+      bitarr_r.rotate_simd(bitarr, j, level);
+    }
+  }
+}
+BENCHMARK(BM_RotateSimd)->ArgName("simd")->DenseRange(0, 2);
 
-constinit const int NUM_BITS = 1230;
+nlg::BitArray<block_type>   bitarr_other{make_bitarray<block_type>(num_bits)};
 
-template <typename T>
-nlg::StaticBitArray<NUM_BITS,T> make_bitarray()
+// Benchmark the surrogate loop, rotate into a temporary and count the common bits
+static void BM_RotateCommon(benchmark::State& state)
 {
-  nlg::StaticBitArray<NUM_BITS,block_type>  statbitarr;
-  std::uniform_int_distribution             bitdistribution(0,NUM_BITS-1);
-  int                                       num_ones = distribution(gen);
+  for (auto _: state)
+  {
+    size_t total = 0;
 
-  for (int j=0; j < num_ones; j++)
+    for (int j = 1; j < num_bits; j++)
+    {
+      nlg::BitArray<block_type> bitarr_r(num_bits);
+      bitarr_r.rotate(bitarr_other, j);
+      total += bitarr.common(bitarr_r);
+    }
+
+    benchmark::DoNotOptimize(total);
+  }
+}
+BENCHMARK(BM_RotateCommon);
+
+// Benchmark the same loop with the fused rotate-and-intersect
+static void BM_CommonRotated(benchmark::State& state)
+{
+  for (auto _: state)
   {
-    int bit{bitdistribution(gen)};
+    size_t total = 0;
 
-    statbitarr.set(bit);
+    for (int j = 1; j < num_bits; j++)
+      total += bitarr.common_rotated(bitarr_other, j);
+
+    benchmark::DoNotOptimize(total);
   }
+}
+BENCHMARK(BM_CommonRotated);
 
-  return statbitarr;
+// Benchmark the whole circular coincidence profile, N rotates and N common()
+static void BM_ProfileByRotate(benchmark::State& state)
+{
+  std::vector<size_t> counts(num_bits);
+
+  for (auto _: state)
+  {
+    for (int j = 0; j < num_bits; j++)
+    {
+      nlg::BitArray<block_type> bitarr_r(num_bits);
+      bitarr_r.rotate(bitarr_other, j);
+      counts[j] = bitarr.common(bitarr_r);
+    }
+
+    benchmark::DoNotOptimize(counts.data());
+  }
 }
+BENCHMARK(BM_ProfileByRotate);
 
-nlg::StaticBitArray<NUM_BITS,block_type>   static_bitarr{make_bitarray<block_type>()};
-nlg::BitArray<block_type>   bitarr4static{NUM_BITS, static_bitarr.begin(),static_bitarr.end()};
+// Benchmark the profile engine, the argument is the method
+//  (0: automatic, 1: direct, 2: sparse, 3: fft)
+static void BM_Profile(benchmark::State& state)
+{
+  auto method = static_cast<nlg::profile_method>(state.range(0));
 
-static void BM_Rotate4Static(benchmark::State& state)
+  for (auto _: state)
+  {
+    auto profile = nlg::circular_coincidence_profile(bitarr, bitarr_other, method);
+
+    benchmark::DoNotOptimize(profile.counts.data());
+  }
+}
+BENCHMARK(BM_Profile)->ArgName("method")->DenseRange(0, 3);
+
+
+// Benchmark K surrogates of one train, K rotates into K separate bit arrays,
+//  the argument is the number of surrogates
+std::vector<size_t> make_shifts(size_t count, size_t size_bits)
+{
+  std::uniform_int_distribution<size_t> shiftdistribution(1,size_bits-1);
+  std::vector<size_t>                   shifts(count);
+
+  for (auto &shift : shifts)
+    shift = shiftdistribution(gen);
+
+  return shifts;
+}
+
+static void BM_RotateSurrogates(benchmark::State& state)
 {
+  std::vector<size_t> shifts = make_shifts(state.range(0), num_bits);
+
   for (auto _: state)
   {
-    for (int j = 1; j < NUM_BITS; j++)
+    std::vector<nlg::BitArray<block_type>> surrogates;
+
+    surrogates.reserve(shifts.size());
+    for (size_t shift : shifts)
     {
-      nlg::BitArray<block_type> bitarr_r(NUM_BITS);
-      bitarr_r.rotate(bitarr4static, j);
+      surrogates.emplace_back(num_bits);
+      surrogates.back().rotate(bitarr, shift);
     }
+
+    benchmark::DoNotOptimize(surrogates.data());
   }
 }
-// Register the function as a benchmark
-BENCHMARK(BM_Rotate4Static);
+BENCHMARK(BM_RotateSurrogates)->Arg(16)->Arg(256);
 
-static void BM_StaticRotate(benchmark::State& state)
+// Benchmark the same surrogates with the batch rotate into one matrix
+static void BM_RotateBatch(benchmark::State& state)
 {
+  std::vector<size_t>        shifts = make_shifts(state.range(0), num_bits);
+  nlg::BitMatrix<block_type> surrogates(shifts.size(), num_bits);
+
   for (auto _: state)
   {
-    for (int j = 1; j < num_bits; j++)
+    surrogates.rotate_batch(bitarr, shifts);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotateBatch)->Arg(16)->Arg(256);
+
+// Benchmark the per trial rotate of a recording of 100 trials of 1230 bins,
+//  by splitting into per trial bit arrays, rotating and stitching back
+constinit const int NUM_TRIALS = 100;
+constinit const int TRIAL_BITS = 1230;
+
+nlg::BitArray<block_type>   recording{make_bitarray<block_type>(NUM_TRIALS * TRIAL_BITS)};
+
+static void BM_RotateTrialsSplit(benchmark::State& state)
+{
+  std::vector<size_t>       shifts = make_shifts(NUM_TRIALS, TRIAL_BITS);
+  nlg::BitArray<block_type> result(NUM_TRIALS * TRIAL_BITS);
+
+  for (auto _: state)
+  {
+    result.reset();
+
+    for (int t = 0; t < NUM_TRIALS; t++)
     {
-      nlg::StaticBitArray<NUM_BITS,block_type> bitarr_r;
-      bitarr_r.rotate(static_bitarr, j);
+      nlg::BitArray<block_type> trial(TRIAL_BITS);
+      nlg::BitArray<block_type> trial_r(TRIAL_BITS);
+
+      for (int i = 0; i < TRIAL_BITS; i++)
+        if (recording.at(t * TRIAL_BITS + i))
+          trial.set(i);
+
+      trial_r.rotate(trial, shifts[t]);
+
+      for (int i = 0; i < TRIAL_BITS; i++)
+        if (trial_r.at(i))
+          result.set(t * TRIAL_BITS + i);
     }
+
+    benchmark::ClobberMemory();
   }
 }
-// Register the function as a benchmark
-BENCHMARK(BM_StaticRotate);
+BENCHMARK(BM_RotateTrialsSplit);
+
+// Benchmark the same with the segmented rotate
+static void BM_RotateTrials(benchmark::State& state)
+{
+  std::vector<size_t>       shifts = make_shifts(NUM_TRIALS, TRIAL_BITS);
+  nlg::BitArray<block_type> result{recording};
+
+  for (auto _: state)
+  {
+    result.rotate_trials(TRIAL_BITS, shifts);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotateTrials);
+
+// Benchmark a surrogate round of a population of 2000 neurons,
+//  one rotate call with its own allocation per neuron
+constinit const int NUM_NEURONS = 2000;
+constinit const int NEURON_BITS = 1230;
+
+std::vector<nlg::BitArray<block_type>> make_population()
+{
+  std::vector<nlg::BitArray<block_type>> trains;
+
+  for (int i = 0; i < NUM_NEURONS; i++)
+    trains.push_back(make_bitarray<block_type>(NEURON_BITS));
+
+  return trains;
+}
+
+std::vector<nlg::BitArray<block_type>> population{make_population()};
+
+static void BM_RotatePopulationSerial(benchmark::State& state)
+{
+  std::vector<size_t> shifts = make_shifts(NUM_NEURONS, NEURON_BITS);
+
+  for (auto _: state)
+  {
+    for (int i = 0; i < NUM_NEURONS; i++)
+    {
+      nlg::BitArray<block_type> bitarr_r(NEURON_BITS);
+      bitarr_r.rotate(population[i], shifts[i]);
+      benchmark::DoNotOptimize(bitarr_r.data());
+    }
+  }
+}
+BENCHMARK(BM_RotatePopulationSerial);
+
+// Benchmark the population rotate into preallocated output,
+//  the argument is the number of threads
+static void BM_RotatePopulation(benchmark::State& state)
+{
+  std::vector<size_t>                    shifts = make_shifts(NUM_NEURONS, NEURON_BITS);
+  std::vector<nlg::BitArray<block_type>> out(NUM_NEURONS, nlg::BitArray<block_type>(NEURON_BITS));
+
+  for (auto _: state)
+  {
+    nlg::rotate_population(population, shifts, out, static_cast<unsigned>(state.range(0)));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotatePopulation)->ArgName("threads")->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// the previous blockwise implementation of (right) rotate, which handles
+//  the seam and the tail inside the main loop; the baseline of
+//  BM_RotateBlockwiseBySize
+static NOINLINE void rotate_blockwise(block_type *dst, block_type const *src, size_t num_bits, size_t n)
+{
+  constexpr size_t bits_per_block = nlg::BitArray<block_type>::bits_per_block;
+
+  size_t const num_blocks = (num_bits - 1) / bits_per_block + 1;
+
+  if (n >= num_bits)
+    n %= num_bits;
+
+  if (n == 0)
+  {
+    std::copy(src, src + num_blocks, dst);
+
+    return;
+  }
+
+  size_t  start_blk_pos{(num_bits - n) / bits_per_block};
+  size_t  start_bit_pos{(num_bits - n) % bits_per_block};
+
+  size_t  opos{0};
+  size_t  iblk_pos{start_blk_pos};
+  size_t  ibit_pos{start_bit_pos};
+  size_t  last_bits = num_bits % bits_per_block;
+
+  while (opos < num_blocks)
+  {
+    block_type block{src[iblk_pos]};
+
+    // make block for output
+    block = (ibit_pos >= bits_per_block) ?  0 :  block >> ibit_pos;
+
+
+    if ( (start_bit_pos == ibit_pos) && (iblk_pos == num_blocks-1) )
+      ibit_pos = last_bits == 0 ? ibit_pos : (bits_per_block - (last_bits - ibit_pos));
+
+    iblk_pos++;
+    if (iblk_pos == num_blocks)
+      iblk_pos = 0;
+
+    if ( (iblk_pos == num_blocks-1) && (iblk_pos != start_blk_pos) )
+    {
+      block_type rblock{src[iblk_pos]};
+
+      rblock = (ibit_pos == 0) ? static_cast<block_type>(0) : rblock << (bits_per_block-ibit_pos);
+      block |= rblock;
+
+      if ( (last_bits == 0) || (last_bits >= ibit_pos) )
+      {
+        dst[opos] = block;
+        opos++;
+
+        rblock = src[iblk_pos];
+        block = rblock >> ibit_pos;
+
+        // a size multiple of the block size has no tail to mask, the
+        //  shift by last_bits - ibit_pos would be out of range
+        if (last_bits != 0)
+          block &= ~(~static_cast<block_type>(0) << (last_bits-ibit_pos));
+
+        ibit_pos = (last_bits == 0) ? ibit_pos : (bits_per_block-(last_bits - ibit_pos));
+
+        if ( (ibit_pos==0) && (last_bits == 0) )
+          continue;
+      }
+      else
+      {
+        ibit_pos -= last_bits;
+        // ibit_pos = last_bits + (bits_per_block - ibit_pos);
+      }
+      iblk_pos = 0;
+    }
+
+    if (iblk_pos == start_blk_pos)
+    {
+      block_type rblock{src[iblk_pos]};
+
+      rblock = (ibit_pos == 0) ? 0 : rblock << (bits_per_block-ibit_pos);
+
+      if (ibit_pos >= start_bit_pos)
+      {
+        if (last_bits == 0)
+        {
+          block |= rblock;
+        }
+        else
+        {
+          rblock &= (~static_cast<block_type>(0) >> (bits_per_block - last_bits));
+          block |= rblock;
+          block &= ~(~static_cast<block_type>(0) << last_bits);
+        }
+      }
+      else
+      {
+        block |= rblock;
+
+        dst[opos] = block;
+        opos++;
+
+        assert(opos == num_blocks-1);
+
+        block = src[start_blk_pos];
+
+        block >>= ibit_pos;
+        block &= ~(~static_cast<block_type>(0) << last_bits);
+      }
+    }
+    else
+    {
+      block_type rblock{src[iblk_pos]};
+
+      rblock = (ibit_pos == 0) ? 0 : rblock << (bits_per_block-ibit_pos);
+      block |= rblock;
+    }
+
+    dst[opos] = block;
+    opos++;
+  }
+}
+
+// Benchmark the rotate kernels per size class, the argument is the number of bits
+static void BM_RotateBySize(benchmark::State& state)
+{
+  int                       size_bits = static_cast<int>(state.range(0));
+  nlg::BitArray<block_type> size_bitarr{make_bitarray<block_type>(size_bits)};
+  nlg::BitArray<block_type> bitarr_r(size_bits);
+  size_t                    shift = 1;
+
+  for (auto _: state)
+  {
+    shift = (shift * 7919 + 13) % size_bits;
+    bitarr_r.rotate(size_bitarr, shift);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotateBySize)->Arg(100)->Arg(1230)->Arg(4113)->Arg(65537)->Arg(1 << 20);
+
+static void BM_RotateBlockwiseBySize(benchmark::State& state)
+{
+  int                       size_bits = static_cast<int>(state.range(0));
+  nlg::BitArray<block_type> size_bitarr{make_bitarray<block_type>(size_bits)};
+  std::vector<block_type>   bits_r(size_bitarr.num_blocks());
+  size_t                    shift = 1;
+
+  for (auto _: state)
+  {
+    shift = (shift * 7919 + 13) % size_bits;
+    rotate_blockwise(bits_r.data(), size_bitarr.data(), size_bits, shift);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotateBlockwiseBySize)->Arg(100)->Arg(1230)->Arg(4113)->Arg(65537)->Arg(1 << 20);
+
+// Benchmark the rotate of long trains into a second buffer,
+//  the argument is the number of bits
+static void BM_RotateLong(benchmark::State& state)
+{
+  int                       long_bits = static_cast<int>(state.range(0));
+  nlg::BitArray<block_type> long_bitarr{make_bitarray<block_type>(long_bits)};
+  nlg::BitArray<block_type> bitarr_r(long_bits);
+  size_t                    shift = 1;
+
+  for (auto _: state)
+  {
+    shift = (shift * 7919 + 13) % long_bits;
+    bitarr_r.rotate(long_bitarr, shift);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotateLong)->RangeMultiplier(8)->Range(1 << 15, 1 << 24)->Arg((1 << 21) + 37)->Arg((1 << 24) + 37);
+
+// Benchmark the in place rotate of long trains
+static void BM_RotateInplaceLong(benchmark::State& state)
+{
+  int                       long_bits = static_cast<int>(state.range(0));
+  nlg::BitArray<block_type> long_bitarr{make_bitarray<block_type>(long_bits)};
+  size_t                    shift = 1;
+
+  for (auto _: state)
+  {
+    shift = (shift * 7919 + 13) % long_bits;
+    long_bitarr.rotate_inplace(shift);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RotateInplaceLong)->RangeMultiplier(8)->Range(1 << 15, 1 << 24)->Arg((1 << 21) + 37)->Arg((1 << 24) + 37);
+
+constexpr int MASK_BITS = 1 << 16;
+
+nlg::BitArray<block_type>   mask_bitarr{make_bitarray<block_type>(MASK_BITS)};
+
+// the former mask builder, dt passes of a one bit shift, as the baseline of the curve
+void left_mask_by_passes(std::vector<block_type> &mask, std::vector<block_type> &shifted, nlg::BitArray<block_type> const &src, int dt)
+{
+  std::copy(src.data(), src.data() + src.num_blocks(), mask.begin());
+  std::copy(src.data(), src.data() + src.num_blocks(), shifted.begin());
+
+  for (int ir = 0; ir < dt; ir++)
+  {
+    block_type prev = 0;
+
+    for (size_t i = 0; i < shifted.size(); i++)
+    {
+      block_type const newv = (shifted[i] << 1) | (prev >> 63);
+
+      prev       = shifted[i];
+      shifted[i] = newv;
+      mask[i]   |= newv;
+    }
+  }
+}
+
+// Benchmark the neighbour masks, the argument is the window dt
+static void BM_LeftNeighbourMask(benchmark::State& state)
+{
+  int                       dt = static_cast<int>(state.range(0));
+  nlg::BitArray<block_type> mask(MASK_BITS);
+
+  for (auto _: state)
+  {
+    mask.createLeftNeighbourMask(mask_bitarr, dt);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_LeftNeighbourMask)->ArgName("dt")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(63)->Arg(100)->Arg(250)->Arg(500);
+
+static void BM_RightNeighbourMask(benchmark::State& state)
+{
+  int                       dt = static_cast<int>(state.range(0));
+  nlg::BitArray<block_type> mask(MASK_BITS);
+
+  for (auto _: state)
+  {
+    mask.createRightNeighbourMask(mask_bitarr, dt);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_RightNeighbourMask)->ArgName("dt")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(63)->Arg(100)->Arg(250)->Arg(500);
+
+static void BM_LeftNeighbourMaskPasses(benchmark::State& state)
+{
+  int                     dt = static_cast<int>(state.range(0));
+  std::vector<block_type> mask(mask_bitarr.num_blocks());
+  std::vector<block_type> shifted(mask_bitarr.num_blocks());
+
+  for (auto _: state)
+  {
+    left_mask_by_passes(mask, shifted, mask_bitarr, dt);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_LeftNeighbourMaskPasses)->ArgName("dt")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(63)->Arg(100)->Arg(250)->Arg(500);
+
+nlg::BitArray<block_type>   mask_bitarr_other{make_bitarray<block_type>(MASK_BITS)};
+
+// Benchmark the dense (dilation) and the sparse (runs) mask kernels by the
+//  density of the train, the argument is the number of spikes per 10000 bins
+nlg::BitArray<block_type> make_density_bitarray(int per_10000)
+{
+  nlg::BitArray<block_type> bits(MASK_BITS);
+  std::bernoulli_distribution spike(per_10000 / 10000.0);
+
+  for (int t = 0; t < MASK_BITS; t++)
+    if (spike(gen))
+      bits.set(t);
+
+  return bits;
+}
+
+static void BM_DenseMaskByDensity(benchmark::State& state)
+{
+  auto                    src = make_density_bitarray(static_cast<int>(state.range(0)));
+  std::vector<block_type> mask(src.num_blocks());
+  block_type             *out = mask.data();
+
+  for (auto _: state)
+  {
+    nlg::kernels::dilate_left(src.data(), src.size(), 20, [out](size_t i, block_type block) { out[i] = block; });
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_DenseMaskByDensity)->ArgName("per10k")->Arg(10)->Arg(50)->Arg(100)->Arg(300)->Arg(1000)->Arg(3000);
+
+static void BM_SparseMaskByDensity(benchmark::State& state)
+{
+  auto                    src = make_density_bitarray(static_cast<int>(state.range(0)));
+  std::vector<block_type> mask(src.num_blocks());
+
+  for (auto _: state)
+  {
+    benchmark::DoNotOptimize(nlg::kernels::sparse_mask(mask.data(), src.data(), src.size(), 20, true));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_SparseMaskByDensity)->ArgName("per10k")->Arg(10)->Arg(50)->Arg(100)->Arg(300)->Arg(1000)->Arg(3000);
+
+// from the spike positions, e.g., as they come from the recordings
+static void BM_SpikesMaskByDensity(benchmark::State& state)
+{
+  auto                    src = make_density_bitarray(static_cast<int>(state.range(0)));
+  std::vector<block_type> mask(src.num_blocks());
+  std::vector<uint32_t>   spikes;
+
+  for (uint32_t t = 0; t < src.size(); t++)
+    if (src.at(t))
+      spikes.push_back(t);
+
+  for (auto _: state)
+  {
+    benchmark::DoNotOptimize(nlg::kernels::sparse_mask(mask.data(), src.size(), std::span<uint32_t const>(spikes), 20, true));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_SpikesMaskByDensity)->ArgName("per10k")->Arg(10)->Arg(50)->Arg(100)->Arg(300)->Arg(1000)->Arg(3000);
+
+// Benchmark the coincidence query, mask into a temporary then common(), against
+//  the fused counter, the argument is the window dt
+static void BM_MaskCommon(benchmark::State& state)
+{
+  int dt = static_cast<int>(state.range(0));
+
+  for (auto _: state)
+  {
+    nlg::BitArray<block_type> mask(MASK_BITS);
+
+    mask.createLeftNeighbourMask(mask_bitarr_other, dt);
+    benchmark::DoNotOptimize(mask_bitarr.common(mask));
+  }
+}
+BENCHMARK(BM_MaskCommon)->ArgName("dt")->Arg(2)->Arg(32)->Arg(500);
+
+static void BM_CountLeftCoincidences(benchmark::State& state)
+{
+  size_t dt = static_cast<size_t>(state.range(0));
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(nlg::count_left_coincidences(mask_bitarr, mask_bitarr_other, dt));
+}
+BENCHMARK(BM_CountLeftCoincidences)->ArgName("dt")->Arg(2)->Arg(32)->Arg(500);
+
+static void BM_CountCircularLeftCoincidences(benchmark::State& state)
+{
+  size_t dt = static_cast<size_t>(state.range(0));
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(nlg::count_circular_left_coincidences(mask_bitarr, mask_bitarr_other, dt));
+}
+BENCHMARK(BM_CountCircularLeftCoincidences)->ArgName("dt")->Arg(2)->Arg(32)->Arg(500);
+
+// Benchmark the lag window query [dt_min, dt_max] = [5, 40], two neighbour
+//  masks and their difference against the fused lag counter
+static void BM_LagByTwoMasks(benchmark::State& state)
+{
+  nlg::BitArray<block_type> wide(MASK_BITS);
+  nlg::BitArray<block_type> narrow(MASK_BITS);
+
+  for (auto _: state)
+  {
+    wide.createLeftNeighbourMask(mask_bitarr_other, 40);
+    narrow.createLeftNeighbourMask(mask_bitarr_other, 4);
+    benchmark::DoNotOptimize(mask_bitarr.common(wide) - mask_bitarr.common(narrow));
+  }
+}
+BENCHMARK(BM_LagByTwoMasks);
+
+static void BM_CountLeftLagCoincidences(benchmark::State& state)
+{
+  for (auto _: state)
+    benchmark::DoNotOptimize(nlg::count_left_lag_coincidences(mask_bitarr, mask_bitarr_other, 5, 40));
+}
+BENCHMARK(BM_CountLeftLagCoincidences);
+
+// Benchmark the window sweep dt = 0..50, one fused count per window
+//  against the one pass sweep
+static void BM_SweepByCounts(benchmark::State& state)
+{
+  std::vector<size_t> counts(51);
+
+  for (auto _: state)
+  {
+    for (size_t dt = 0; dt <= 50; dt++)
+      counts[dt] = nlg::count_left_coincidences(mask_bitarr, mask_bitarr_other, dt);
+
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_SweepByCounts);
+
+static void BM_SweepCoincidences(benchmark::State& state)
+{
+  for (auto _: state)
+    benchmark::DoNotOptimize(nlg::sweep_coincidences(mask_bitarr, mask_bitarr_other, 50, nlg::window_side::symmetric));
+}
+BENCHMARK(BM_SweepCoincidences);
+
+// Benchmark the pair x surrogate loop, a rotate surrogate of b, its mask and
+//  the coincidences with a, with fresh temporaries and with a workspace;
+//  the counter 'allocs' is the number of allocations per iteration
+constexpr int PAIR_TRAINS = 8;
+constexpr int PAIR_BITS   = 4096;
+
+std::vector<nlg::BitArray<block_type>> make_pair_trains()
+{
+  std::vector<nlg::BitArray<block_type>> trains;
+
+  for (int i = 0; i < PAIR_TRAINS; i++)
+    trains.push_back(make_bitarray<block_type>(PAIR_BITS));
+
+  return trains;
+}
+
+std::vector<nlg::BitArray<block_type>> pair_trains{make_pair_trains()};
+
+static void BM_PairLoopFresh(benchmark::State& state)
+{
+  size_t const allocations = num_allocations.load();
+  size_t       shift       = 1;
+
+  for (auto _: state)
+  {
+    for (auto const &a : pair_trains)
+      for (auto const &b : pair_trains)
+      {
+        shift = (shift * 7919 + 13) % PAIR_BITS;
+
+        nlg::BitArray<block_type> b_r(PAIR_BITS);
+        nlg::BitArray<block_type> mask(PAIR_BITS);
+
+        b_r.rotate(b, shift);
+        mask.createLeftNeighbourMask(b_r, 20);
+        benchmark::DoNotOptimize(a.common(mask));
+      }
+  }
+
+  state.counters["allocs"] = benchmark::Counter(double(num_allocations.load() - allocations), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_PairLoopFresh);
+
+static void BM_PairLoopWorkspace(benchmark::State& state)
+{
+  auto   &workspace = nlg::BitArray<block_type>::workspace_type::local();
+  size_t  shift     = 1;
+
+  workspace.bits(0, PAIR_BITS);    // warm up
+
+  size_t const allocations = num_allocations.load();
+
+  for (auto _: state)
+  {
+    for (auto const &a : pair_trains)
+      for (auto const &b : pair_trains)
+      {
+        shift = (shift * 7919 + 13) % PAIR_BITS;
+
+        auto &b_r = workspace.bits(0, PAIR_BITS);
+
+        b_r.rotate(b, shift);
+        benchmark::DoNotOptimize(nlg::count_left_coincidences(a, b_r, 20));
+      }
+  }
+
+  state.counters["allocs"] = benchmark::Counter(double(num_allocations.load() - allocations), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_PairLoopWorkspace);
+
+// Benchmark the all pairs left coincidences of a population, the masks
+//  rebuilt for every pair against the mask cache
+constexpr int CACHE_TRAINS = 200;
+
+std::vector<nlg::BitArray<block_type>> make_cache_trains()
+{
+  std::vector<nlg::BitArray<block_type>> trains;
+
+  for (int i = 0; i < CACHE_TRAINS; i++)
+    trains.push_back(make_bitarray<block_type>(PAIR_BITS));
+
+  return trains;
+}
+
+std::vector<nlg::BitArray<block_type>> cache_trains{make_cache_trains()};
+
+static void BM_AllPairsMasks(benchmark::State& state)
+{
+  nlg::BitArray<block_type> mask(PAIR_BITS);
+
+  for (auto _: state)
+  {
+    for (auto const &a : cache_trains)
+      for (auto const &b : cache_trains)
+      {
+        mask.createLeftNeighbourMask(b, 20);
+        benchmark::DoNotOptimize(a.common(mask));
+      }
+  }
+}
+BENCHMARK(BM_AllPairsMasks)->Unit(benchmark::kMillisecond);
+
+static void BM_AllPairsMaskCache(benchmark::State& state)
+{
+  std::vector<size_t> const  dts{20};
+  nlg::MaskCache<block_type> cache(cache_trains, dts);
+
+  for (auto _: state)
+  {
+    for (auto const &a : cache_trains)
+      for (size_t j = 0; j < cache_trains.size(); j++)
+        benchmark::DoNotOptimize(cache.coincidences(a, j, nlg::mask_kind::left, 20));
+  }
+
+  state.counters["builds"] = double(cache.num_builds());
+}
+BENCHMARK(BM_AllPairsMaskCache)->Unit(benchmark::kMillisecond);
+
+// the count policies, a mask built in bulk (with and without a count()
+//  after it) and a train written with set()
+
+template <typename Policy>
+using policy_bitarray = nlg::BitArray<block_type,std::allocator<block_type>,Policy>;
+
+template <typename Policy>
+static void BM_MaskByCountPolicy(benchmark::State& state)
+{
+  policy_bitarray<Policy> const src(MASK_BITS, mask_bitarr.begin(), mask_bitarr.end());
+  policy_bitarray<Policy>       mask(MASK_BITS);
+  bool const                    counted = state.range(0) != 0;
+
+  for (auto _: state)
+  {
+    mask.createLeftNeighbourMask(src, 8);
+
+    if (counted)
+      benchmark::DoNotOptimize(mask.count());
+
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK_TEMPLATE(BM_MaskByCountPolicy, nlg::count_none)->ArgName("count")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_MaskByCountPolicy, nlg::count_eager)->ArgName("count")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_MaskByCountPolicy, nlg::count_lazy)->ArgName("count")->Arg(0)->Arg(1);
+
+template <typename Policy>
+static void BM_SetByCountPolicy(benchmark::State& state)
+{
+  std::uniform_int_distribution bitdistribution(0,MASK_BITS-1);
+  std::vector<uint32_t>         positions(MASK_BITS / 16);
+  policy_bitarray<Policy>       bits(MASK_BITS);
+
+  for (auto &pos : positions)
+    pos = uint32_t(bitdistribution(gen));
+
+  for (auto _: state)
+  {
+    for (uint32_t pos : positions)
+      bits.set(pos);
+
+    benchmark::DoNotOptimize(bits.count());
+  }
+}
+BENCHMARK_TEMPLATE(BM_SetByCountPolicy, nlg::count_none);
+BENCHMARK_TEMPLATE(BM_SetByCountPolicy, nlg::count_eager);
+BENCHMARK_TEMPLATE(BM_SetByCountPolicy, nlg::count_lazy);
+
+// the popcount kernels over sizes, the first argument is the kernel
+//  (0: one popcount per block, 1: Harley-Seal, 2: AVX2 Harley-Seal)
+static void BM_Popcount(benchmark::State& state)
+{
+  nlg::BitArray<block_type> const bits{make_bitarray<block_type>(int(state.range(1)))};
+  int const                        kernel = int(state.range(0));
+
+  for (auto _: state)
+  {
+    switch (kernel)
+    {
+      case 0:  benchmark::DoNotOptimize(nlg::kernels::popcount_scalar(bits.data(), bits.num_blocks())); break;
+      case 1:  benchmark::DoNotOptimize(nlg::kernels::popcount_harley_seal(bits.data(), bits.num_blocks())); break;
+      default: benchmark::DoNotOptimize(nlg::kernels::popcount(nlg::kernels::simd_level::avx2, bits.data(), bits.num_blocks())); break;
+    }
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(bits.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_Popcount)->ArgNames({"kernel", "bits"})->ArgsProduct({{0, 1, 2}, {1 << 10, 1 << 16, 1 << 20, 1 << 24}});
+
+// the recount over sizes with the serial kernel and with the threads, the
+//  parallel one pays from about 2 x recount_grain blocks on
+static void BM_Recount(benchmark::State& state)
+{
+  nlg::BitArray<block_type> bits{make_bitarray<block_type>(int(state.range(1)))};
+  unsigned const            num_threads = unsigned(state.range(0));
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(bits.recount(num_threads));
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(bits.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_Recount)->ArgNames({"threads", "bits"})->ArgsProduct({{1, 0}, {1 << 16, 1 << 20, 1 << 23, 1 << 24, 1 << 26}});
+
+// common() over sizes, the first argument is the simd level (0: scalar
+//  Harley-Seal, 1: AVX2 Harley-Seal, 2: AVX-512 VPOPCNTDQ) clamped to the cpu;
+//  the baseline is the former loop of one popcount per block
+static void BM_CommonLoop(benchmark::State& state)
+{
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(0)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(0)))};
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(nlg::kernels::popcount_and_scalar(a.data(), b.data(), a.num_blocks()));
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(2 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_CommonLoop)->ArgName("bits")->Arg(1000)->Arg(10000)->Arg(100000)->Arg(1000000)->Arg(10000000);
+
+static void BM_Common(benchmark::State& state)
+{
+  auto const                      level = static_cast<nlg::kernels::simd_level>(state.range(0));
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(1)))};
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(a.common(b, level));
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(2 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_Common)->ArgNames({"simd", "bits"})->ArgsProduct({{0, 1, 2}, {1000, 10000, 100000, 1000000, 10000000}});
+
+// the triplet count popcount(a & b & c), the baseline makes the temporary
+//  a & b and counts it with c; the fused kernel has the simd levels of
+//  BM_Common
+static void BM_Common3ByTemporary(benchmark::State& state)
+{
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(0)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(0)))};
+  nlg::BitArray<block_type> const c{make_bitarray<block_type>(int(state.range(0)))};
+
+  for (auto _: state)
+  {
+    nlg::BitArray<block_type> ab(a.size());
+
+    std::transform(a.data(), a.data() + a.num_blocks(), b.data(), ab.begin(), std::bit_and<block_type>());
+    benchmark::DoNotOptimize(ab.common(c));
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(3 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_Common3ByTemporary)->ArgName("bits")->Arg(1000)->Arg(100000)->Arg(10000000);
+
+static void BM_Common3(benchmark::State& state)
+{
+  auto const                      level = static_cast<nlg::kernels::simd_level>(state.range(0));
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const c{make_bitarray<block_type>(int(state.range(1)))};
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(a.common(b, c, level));
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(3 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_Common3)->ArgNames({"simd", "bits"})->ArgsProduct({{0, 1, 2}, {1000, 100000, 10000000}});
+
+static void BM_Common4(benchmark::State& state)
+{
+  auto const                      level = static_cast<nlg::kernels::simd_level>(state.range(0));
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const c{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const d{make_bitarray<block_type>(int(state.range(1)))};
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(a.common(b, c, d, level));
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(4 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_Common4)->ArgNames({"simd", "bits"})->ArgsProduct({{0, 1, 2}, {1000, 100000, 10000000}});
+
+// |a|, |b|, |a & b| and |a ^ b| of a pair, the baseline makes one pass per
+//  popcount at the cpu level; pair_stats() has the simd levels of BM_Common
+static void BM_PairStatsByPasses(benchmark::State& state)
+{
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(0)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(0)))};
+
+  for (auto _: state)
+  {
+    nlg::kernels::pair_stats stats;
+
+    stats.ones_a = nlg::kernels::popcount(a.data(), a.num_blocks());
+    stats.ones_b = nlg::kernels::popcount(b.data(), b.num_blocks());
+    stats.common = nlg::kernels::popcount_and(a.data(), b.data(), a.num_blocks());
+    stats.differ = stats.ones_a + stats.ones_b - 2 * stats.common;
+
+    benchmark::DoNotOptimize(stats);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(2 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_PairStatsByPasses)->ArgName("bits")->Arg(1000)->Arg(100000)->Arg(10000000);
+
+static void BM_PairStats(benchmark::State& state)
+{
+  auto const                      level = static_cast<nlg::kernels::simd_level>(state.range(0));
+  nlg::BitArray<block_type> const a{make_bitarray<block_type>(int(state.range(1)))};
+  nlg::BitArray<block_type> const b{make_bitarray<block_type>(int(state.range(1)))};
+
+  for (auto _: state)
+    benchmark::DoNotOptimize(a.pair_stats(b, level));
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(2 * a.num_blocks() * sizeof(block_type)));
+}
+BENCHMARK(BM_PairStats)->ArgNames({"simd", "bits"})->ArgsProduct({{0, 1, 2}, {1000, 100000, 10000000}});
+
+// one neuron against a population, N common() calls against the one vs many
+//  kernel, plain and with the query rotated; the argument is the train size
+constexpr int MANY_TRAINS = 64;
+
+std::vector<nlg::BitArray<block_type>> make_many_trains(int num_bits)
+{
+  std::vector<nlg::BitArray<block_type>> trains;
+
+  for (int i = 0; i < MANY_TRAINS; i++)
+    trains.push_back(make_bitarray<block_type>(num_bits));
+
+  return trains;
+}
+
+static void BM_OneVsManyByCommon(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> counts(trains.size());
+
+  for (auto _: state)
+  {
+    for (size_t j = 0; j < trains.size(); j++)
+      counts[j] = trains[0].common(trains[j]);
+
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_OneVsManyByCommon)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+static void BM_OneVsMany(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> counts(trains.size());
+
+  for (auto _: state)
+  {
+    nlg::count_common(trains[0], trains, counts, 1);
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_OneVsMany)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+static void BM_OneVsManyRotatedByCommon(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> counts(trains.size());
+
+  for (auto _: state)
+  {
+    for (size_t j = 0; j < trains.size(); j++)
+      counts[j] = trains[j].common_rotated(trains[0], 777);
+
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_OneVsManyRotatedByCommon)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+static void BM_OneVsManyRotated(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> counts(trains.size());
+
+  for (auto _: state)
+  {
+    nlg::count_common_rotated(trains[0], 777, trains, counts, 1);
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_OneVsManyRotated)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+// the triplets of a pair with every train, N common() of three arrays
+//  against the batched kernel which makes a & b once per tile
+static void BM_TripletsByCommon(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> counts(trains.size());
+
+  for (auto _: state)
+  {
+    for (size_t j = 0; j < trains.size(); j++)
+      counts[j] = trains[0].common(trains[1], trains[j]);
+
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_TripletsByCommon)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+static void BM_Triplets(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> counts(trains.size());
+
+  for (auto _: state)
+  {
+    nlg::count_common3(trains[0], trains[1], trains, counts, 1);
+    benchmark::DoNotOptimize(counts.data());
+  }
+}
+BENCHMARK(BM_Triplets)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+// the all pairs coincidences of a population, N (N + 1) / 2 common() calls
+//  against the blocked Gram kernel; pair_blocks is the rate of block pairs
+//  (one block of each train of a pair) counted per second
+void set_pair_blocks(benchmark::State& state, std::vector<nlg::BitArray<block_type>> const &trains)
+{
+  double const num_pairs = double(trains.size()) * double(trains.size() + 1) / 2;
+
+  state.counters["pair_blocks"] = benchmark::Counter(num_pairs * double(trains[0].num_blocks()) * double(state.iterations()),
+                                                     benchmark::Counter::kIsRate);
+}
+
+static void BM_GramByCommon(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> gram(trains.size() * trains.size());
+
+  for (auto _: state)
+  {
+    for (size_t i = 0; i < trains.size(); i++)
+      for (size_t j = i; j < trains.size(); j++)
+        gram[i * trains.size() + j] = trains[i].common(trains[j]);
+
+    benchmark::DoNotOptimize(gram.data());
+  }
+
+  set_pair_blocks(state, trains);
+}
+BENCHMARK(BM_GramByCommon)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+static void BM_GramMatrix(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> gram(trains.size() * trains.size());
+
+  for (auto _: state)
+  {
+    nlg::gram_matrix(trains, gram, 1);
+    benchmark::DoNotOptimize(gram.data());
+  }
+
+  set_pair_blocks(state, trains);
+}
+BENCHMARK(BM_GramMatrix)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+// the Jaccard matrix of a population, pair_stats() per pair against the
+//  measure taken from the Gram matrix
+static void BM_JaccardByPairStats(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<double> out(trains.size() * trains.size());
+
+  for (auto _: state)
+  {
+    for (size_t i = 0; i < trains.size(); i++)
+      for (size_t j = i; j < trains.size(); j++)
+        out[i * trains.size() + j] = out[j * trains.size() + i] = trains[i].pair_stats(trains[j]).jaccard();
+
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_JaccardByPairStats)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+static void BM_JaccardMatrix(benchmark::State& state)
+{
+  auto const          trains = make_many_trains(int(state.range(0)));
+  std::vector<size_t> gram(trains.size() * trains.size());
+  std::vector<double> out(trains.size() * trains.size());
+
+  for (auto _: state)
+  {
+    nlg::similarity_matrix(trains, nlg::similarity::jaccard, gram, out, 1);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_JaccardMatrix)->ArgName("bits")->Arg(1 << 12)->Arg(1 << 17)->Arg(1 << 20);
+
+// Benchmarks with static
+
+constinit const int NUM_BITS = 1230;
+
+template <typename T>
+nlg::StaticBitArray<NUM_BITS,T> make_bitarray()
+{
+  nlg::StaticBitArray<NUM_BITS,block_type>  statbitarr;
+  std::uniform_int_distribution             bitdistribution(0,NUM_BITS-1);
+  int                                       num_ones = distribution(gen);
+
+  for (int j=0; j < num_ones; j++)
+  {
+    int bit{bitdistribution(gen)};
+
+    statbitarr.set(bit);
+  }
+
+  return statbitarr;
+}
+
+nlg::StaticBitArray<NUM_BITS,block_type>   static_bitarr{make_bitarray<block_type>()};
+nlg::BitArray<block_type>   bitarr4static{NUM_BITS, static_bitarr.begin(),static_bitarr.end()};
+
+static void BM_Rotate4Static(benchmark::State& state)
+{
+  for (auto _: state)
+  {
+    for (int j = 1; j < NUM_BITS; j++)
+    {
+      nlg::BitArray<block_type> bitarr_r(NUM_BITS);
+      bitarr_r.rotate(bitarr4static, j);
+    }
+  }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_Rotate4Static);
+
+static void BM_StaticRotate(benchmark::State& state)
+{
+  for (auto _: state)
+  {
+    for (int j = 1; j < num_bits; j++)
+    {
+      nlg::StaticBitArray<NUM_BITS,block_type> bitarr_r;
+      bitarr_r.rotate(static_bitarr, j);
+    }
+  }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_StaticRotate);
+
+static void BM_StaticRotateSimd(benchmark::State& state)
+{
+  auto level = nlg::kernels::clamp_simd_level(static_cast<nlg::kernels::simd_level>(state.range(0)));
+
+  for (auto _: state)
+  {
+    for (int j = 1; j < NUM_BITS; j++)
+    {
+      nlg::StaticBitArray<NUM_BITS,block_type> bitarr_r;
+      bitarr_r.rotate_simd(static_bitarr, j, level);
+    }
+  }
+}
+BENCHMARK(BM_StaticRotateSimd)->ArgName("simd")->DenseRange(0, 2);
+
+// Benchmark the runtime and the compile time shift of the static rotate,
+//  for the 1230 bits array and for a block aligned one of 1280 bits
+nlg::StaticBitArray<1280,block_type>   static_aligned_bitarr{};
+
+static void BM_StaticRotateShift(benchmark::State& state)
+{
+  nlg::StaticBitArray<NUM_BITS,block_type> bitarr_r;
+  size_t                                   shift = 617;
+
+  for (auto _: state)
+  {
+    benchmark::DoNotOptimize(shift);
+    bitarr_r.rotate(static_bitarr, shift);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_StaticRotateShift);
+
+static void BM_StaticRotateFixedShift(benchmark::State& state)
+{
+  nlg::StaticBitArray<NUM_BITS,block_type> bitarr_r;
+
+  for (auto _: state)
+  {
+    bitarr_r.rotate<617>(static_bitarr);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_StaticRotateFixedShift);
+
+static void BM_StaticAlignedRotateShift(benchmark::State& state)
+{
+  nlg::StaticBitArray<1280,block_type> bitarr_r;
+  size_t                               shift = 617;
+
+  for (auto _: state)
+  {
+    benchmark::DoNotOptimize(shift);
+    bitarr_r.rotate(static_aligned_bitarr, shift);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_StaticAlignedRotateShift);
+
+static void BM_StaticAlignedRotateFixedShift(benchmark::State& state)
+{
+  nlg::StaticBitArray<1280,block_type> bitarr_r;
+
+  for (auto _: state)
+  {
+    bitarr_r.rotate<617>(static_aligned_bitarr);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_StaticAlignedRotateFixedShift);
 
 // Benchmark the rotateRight
 static void BM_StaticRotateRight(benchmark::State& state)
@@ -18,18 +18,21 @@
 #include <cassert>
 #include <memory>
 #include <vector>
+#include <span>
 #include <bit>
 
+#include "BitKernels.hpp"
+#include "MaskKernels.hpp"
+#include "CountPolicy.hpp"
+#include "Workspace.hpp"
+#include "Parallel.hpp"
+
 #ifdef __has_include
 # if __has_include(<version>)
 #   include <version>
 # endif
 #endif
 
-#ifdef __cpp_lib_execution
-#include <execution>
-#endif  /* __cpp_lib_execution */
-
 #ifdef __cpp_lib_ranges
 #include <ranges>
 #endif /* __cpp_lib_ranges */
@@ -45,7 +48,7 @@
 
 namespace nlg {
 
-template <typename Block=std::uint64_t, typename Allocator=std::allocator<Block>>
+template <typename Block=std::uint64_t, typename Allocator=std::allocator<Block>, typename CountPolicy=count_eager>
 class BitArray
 {
 public:
@@ -53,6 +56,8 @@ public:
   using size_type        = size_t;
   using buffer_type      = std::vector<Block,Allocator>;
   using block_width_type = typename buffer_type::size_type;
+  using workspace_type   = Workspace<BitArray>;
+  using count_policy     = CountPolicy;
 
 #ifdef __cpp_constinit
   static constinit const size_t bits_per_block = std::numeric_limits<Block>::digits;
@@ -60,10 +65,15 @@ public:
   static constexpr const size_t bits_per_block = std::numeric_limits<Block>::digits;
 #endif /*  __cpp_constinit */
 
+  // the blocks per thread of the parallel recount; below two of them the
+  //  serial popcount wins over starting a thread (see BM_Recount)
+  static constexpr const size_t recount_grain = size_t(1) << 17;
+
 private:
   size_t       m_bitset_capacity;
   size_t       m_num_bits;
-  size_t       m_count{0};
+  CountPolicy  m_counter;
+  uint64_t     m_generation{0};
   buffer_type  m_bits;
 
 private:
@@ -71,6 +81,45 @@ private:
   static block_width_type bit_index  (size_type pos) noexcept { return static_cast<block_width_type>(pos % bits_per_block); }
   static Block            bit_mask   (size_type pos) noexcept { return Block(1) << bit_index(pos); }
 
+  void touch() noexcept { m_generation++; }
+
+  // store the blocks which a mask kernel emits, counting them on the way
+  //  when the policy keeps an eager count
+  template <typename Kernel>
+  void store_blocks(Kernel &&kernel)
+  {
+    block_type *const out = m_bits.data();
+
+    if constexpr (CountPolicy::counts_bulk)
+    {
+      size_t count = 0;
+
+      kernel([out, &count](size_t i, block_type block)
+      {
+        out[i]  = block;
+        count  += std::popcount(block);
+      });
+
+      m_counter.assign(count);
+    }
+    else
+    {
+      kernel([out](size_t i, block_type block) { out[i] = block; });
+
+      m_counter.invalidate(out, num_blocks());
+    }
+  }
+
+  // take the sizes of other for a mask kernel which writes every block, so
+  //  the blocks of other are not copied only to be overwritten
+  void assign_shape(BitArray const &other)
+  {
+    m_bits.resize(other.m_bits.size());
+    m_num_bits        = other.m_num_bits;
+    m_bitset_capacity = other.m_bitset_capacity;
+    m_counter         = other.m_counter;
+  }
+
 public:
 
   explicit BitArray(std::size_t num_bits) :
@@ -83,6 +132,7 @@ public:
   BitArray(std::size_t num_bits, Iterator beg, Iterator end) : BitArray(num_bits)
   {
     std::copy(beg,end,m_bits.begin());
+    m_counter.invalidate(m_bits.data(), num_blocks());
   }
 
 
@@ -90,8 +140,33 @@ public:
   BitArray(BitArray const &) = default;
   BitArray(BitArray &&) noexcept = default;
 
-  BitArray &operator=(BitArray const &) = default;
-  BitArray &operator=(BitArray &&) noexcept = default;
+  // the assignments move the generation past both operands, so it never
+  //  returns to a value the array had with other contents
+  BitArray &operator=(BitArray const &other)
+  {
+    uint64_t const generation = std::max(m_generation, other.m_generation) + 1;
+
+    m_bitset_capacity = other.m_bitset_capacity;
+    m_num_bits        = other.m_num_bits;
+    m_counter         = other.m_counter;
+    m_bits            = other.m_bits;
+    m_generation      = generation;
+
+    return *this;
+  }
+
+  BitArray &operator=(BitArray &&other) noexcept
+  {
+    uint64_t const generation = std::max(m_generation, other.m_generation) + 1;
+
+    m_bitset_capacity = other.m_bitset_capacity;
+    m_num_bits        = other.m_num_bits;
+    m_counter         = other.m_counter;
+    m_bits            = std::move(other.m_bits);
+    m_generation      = generation;
+
+    return *this;
+  }
 
   ~BitArray() = default;
 
@@ -99,8 +174,8 @@ public:
   {
     assert(pos < m_num_bits);
 
-    m_bits[block_index(pos)] |= bit_mask(pos);
-    m_count++;
+    m_counter.set(m_bits[block_index(pos)], bit_mask(pos));
+    touch();
 
     return *this;
   }
@@ -109,8 +184,8 @@ public:
   {
     assert(pos < m_num_bits);
 
-    m_bits[block_index(pos)] &= ~bit_mask(pos);
-    m_count--;
+    m_counter.clear(m_bits[block_index(pos)], bit_mask(pos));
+    touch();
 
     return *this;
   }
@@ -132,7 +207,8 @@ public:
     std::fill(begin(),end(),Block(0));
 #endif /* __cpp_lib_ranges */
 
-    m_count = 0;
+    m_counter.assign(0);
+    touch();
   }
 
   [[nodiscard]] size_type num_blocks() const noexcept
@@ -140,160 +216,252 @@ public:
     return static_cast<size_type>(m_bits.size());
   }
 
+  // the number of set bits as the count policy keeps it, O(1) unless the
+  //  policy is count_none or a count_lazy one is dirty
   [[nodiscard]] size_t count() const
   {
-    return m_count;
+    return m_counter.count(m_bits.data(), num_blocks());
   }
 
-  // return the number of set bits
-  size_t recount()
+  // a counter which changes on every modification through the members
+  //  (set, clear, reset, the rotates, the masks and the assignments), so
+  //  the caches of derived data, e.g., the MaskCache, can tell whether
+  //  they are stale; writes through the block iterators are not seen
+  [[nodiscard]] uint64_t generation() const noexcept
   {
-#ifdef __cpp_lib_execution
-      std::atomic<size_t> _count = 0;
+    return m_generation;
+  }
 
-      std::for_each(std::execution::par_unseq, begin(), end(),
-                    [&](block_type block) { _count += std::popcount(block); });
+  // return the number of set bits, counted anew, and resynchronize count(),
+  //  e.g., after writes through the block iterators; the large arrays are
+  //  split in one chunk per thread, each summed into its own partial count
+  size_t recount(unsigned num_threads = 0)
+  {
+    size_t const max_chunks = num_blocks() / recount_grain;
+    size_t const num_chunks = (max_chunks <= 1) ? max_chunks
+                                                : std::min<size_t>((num_threads == 0) ? default_num_threads() : num_threads, max_chunks);
+    size_t       _count     = 0;
+
+    if (num_chunks <= 1)
+      _count = kernels::popcount(m_bits.data(), num_blocks());
+    else
+    {
+      std::vector<size_t> partials(num_chunks);
 
-      return _count;
-#else
-    size_t _count = 0;
+      parallel_for_static(num_chunks, unsigned(num_chunks), [&](size_t beg, size_t end)
+      {
+        for (size_t c = beg; c < end; c++)
+        {
+          size_t const first = num_blocks() * c / num_chunks;
+          size_t const last  = num_blocks() * (c + 1) / num_chunks;
+
+          partials[c] = kernels::popcount(m_bits.data() + first, last - first);
+        }
+      });
 
-      std::for_each(begin(), end(),
-                    [&](block_type block) { _count += std::popcount(block); });
+      for (size_t partial : partials)
+        _count += partial;
+    }
 
-      return _count;
-#endif /* __cpp_lib_execution */
+    m_counter.assign(_count);
+
+    return _count;
   }
 
-  // return the number of common set bits (intersection of the two bitsets)
-  [[nodiscard]]  size_t common(BitArray const &other)
+  // return the number of common set bits (intersection of the two bitsets),
+  //  the kernel (AVX-512 VPOPCNTDQ, AVX2 or scalar) is chosen at runtime
+  [[nodiscard]]  size_t common(BitArray const &other,
+                               kernels::simd_level level = kernels::cpu_simd_level()) const
   {
     assert(m_num_bits == other.m_num_bits);
 
-    size_t _count = 0;
+    return kernels::popcount_and(level, m_bits.data(), other.m_bits.data(), num_blocks());
+  }
 
-    for (block_type const *lp=m_bits.data(), *rp=other.m_bits.data(), *lend=m_bits.data()+m_bits.size(); lp < lend; lp++,rp++)
-      _count += std::popcount(*lp & *rp);
+  // return |this|, |other|, their common and their differing set bits in one
+  //  pass; the counts come from the bits, not from the count policy
+  [[nodiscard]]  kernels::pair_stats pair_stats(BitArray const &other,
+                                                kernels::simd_level level = kernels::cpu_simd_level()) const
+  {
+    assert(m_num_bits == other.m_num_bits);
 
-    return _count;
+    return kernels::popcount_pair(level, m_bits.data(), other.m_bits.data(), num_blocks());
   }
 
-  // The fast blockwise implementation of (right) rotate
-  NOINLINE void rotate(BitArray const &other, size_t n)
+  // return the number of set bits common to the three (four) bitsets, i.e.,
+  //  common(b & c) in one pass without the temporary intersection
+  [[nodiscard]]  size_t common(BitArray const &b, BitArray const &c,
+                               kernels::simd_level level = kernels::cpu_simd_level()) const
   {
-    assert(size() == other.size());
-    assert(m_bits.size() == other.m_bits.size());
+    assert( (m_num_bits == b.m_num_bits) && (m_num_bits == c.m_num_bits) );
 
-    if (n >= m_num_bits)
-      n %= m_num_bits;
+    return kernels::popcount_and3(level, m_bits.data(), b.m_bits.data(), c.m_bits.data(), num_blocks());
+  }
 
-    if (n == 0)
+  [[nodiscard]]  size_t common(BitArray const &b, BitArray const &c, BitArray const &d,
+                               kernels::simd_level level = kernels::cpu_simd_level()) const
+  {
+    assert( (m_num_bits == b.m_num_bits) && (m_num_bits == c.m_num_bits) && (m_num_bits == d.m_num_bits) );
+
+    return kernels::popcount_and4(level, m_bits.data(), b.m_bits.data(), c.m_bits.data(), d.m_bits.data(), num_blocks());
+  }
+
+  // (right) rotate in place every segment [bounds[i], bounds[i+1]) by shifts[i],
+  //  so that no bit crosses a segment boundary; the bounds are increasing
+  //  and shifts has one element less than bounds; the scratch buffer is
+  //  borrowed from the workspace
+  void rotate_segments(std::span<size_t const> bounds, std::span<size_t const> shifts,
+                       workspace_type &workspace = workspace_type::local())
+  {
+    touch();
+
+    assert(bounds.size() == shifts.size() + 1);
+
+    size_type max_blocks{0};
+
+    for (size_t i = 0; i < shifts.size(); i++)
     {
-      *this = other;
+      assert( (bounds[i] < bounds[i+1]) && (bounds[i+1] <= m_num_bits) );
 
-      return;
+      max_blocks = std::max(max_blocks, block_index(bounds[i+1] - bounds[i] - 1) + 1);
+    }
+
+    buffer_type &scratch = workspace.scratch(max_blocks);
+
+    for (size_t i = 0; i < shifts.size(); i++)
+    {
+      size_t const len = bounds[i+1] - bounds[i];
+      size_t const n   = shifts[i] % len;
+
+      if (n != 0)
+        kernels::rotate_segment_inplace(kernels::cpu_simd_level(), m_bits.data(), num_blocks(),
+                                        bounds[i], len, n, scratch.data());
     }
+  }
+
+  // (right) rotate in place every trial of 'trial_len' bits by shifts[i],
+  //  the last trial may be shorter
+  void rotate_trials(size_t trial_len, std::span<size_t const> shifts,
+                     workspace_type &workspace = workspace_type::local())
+  {
+    touch();
 
-    size_type  start_blk_pos{block_index(m_num_bits - n)};
-    size_type  start_bit_pos{bit_index(m_num_bits - n)};
+    assert(trial_len > 0);
+    assert(shifts.size() == (m_num_bits + trial_len - 1) / trial_len);
 
-    size_type  opos{0};
-    size_type  iblk_pos{start_blk_pos};
-    size_type  ibit_pos{start_bit_pos};
-    size_type  last_bits = m_num_bits % bits_per_block;
+    buffer_type &scratch = workspace.scratch(block_index(trial_len - 1) + 1);
 
-    while (opos < num_blocks())
+    for (size_t i = 0, offset = 0; i < shifts.size(); i++, offset += trial_len)
     {
-      block_type block{other.m_bits[iblk_pos]};
+      size_t const len = std::min(trial_len, m_num_bits - offset);
+      size_t const n   = shifts[i] % len;
 
-      // make block for output
-      block = (ibit_pos >= bits_per_block) ?  0 :  block >> ibit_pos;
+      if (n != 0)
+        kernels::rotate_segment_inplace(kernels::cpu_simd_level(), m_bits.data(), num_blocks(),
+                                        offset, len, n, scratch.data());
+    }
+  }
 
+  // return the number of common set bits with the (right) rotate of other by n,
+  //  i.e., common(rotate(other, n)) computed in one pass without the temporary
+  [[nodiscard]] size_t common_rotated(BitArray const &other, size_t n,
+                                      kernels::simd_level level = kernels::cpu_simd_level()) const
+  {
+    assert(m_num_bits == other.m_num_bits);
 
-      if ( (start_bit_pos == ibit_pos) && (iblk_pos == num_blocks()-1) )
-        ibit_pos = last_bits == 0 ? ibit_pos : (bits_per_block - (last_bits - ibit_pos));
+    if (n >= m_num_bits)
+      n %= m_num_bits;
 
-      iblk_pos++;
-      if (iblk_pos == num_blocks())
-        iblk_pos = 0;
+    if (n == 0)
+      return common(other, level);
 
-      if ( (iblk_pos == num_blocks()-1) && (iblk_pos != start_blk_pos) )
-      {
-        block_type rblock{other.m_bits[iblk_pos]};
+    return kernels::popcount_and_rotated(level, m_bits.data(), other.m_bits.data(), m_num_bits, n);
+  }
 
-        rblock = (ibit_pos == 0) ? static_cast<block_type>(0) : rblock << (bits_per_block-ibit_pos);
-        block |= rblock;
+  // (right) rotate in place, without a second buffer
+  NOINLINE void rotate_inplace(size_t n)
+  {
+    touch();
 
-        if ( (last_bits == 0) || (last_bits >= ibit_pos) )
-        {
-          m_bits.at(opos) = block;
-          opos++;
+    if (n >= m_num_bits)
+      n %= m_num_bits;
 
-          rblock = other.m_bits[iblk_pos];
-          block = (rblock >> ibit_pos) & ~(~static_cast<block_type>(0) << (last_bits-ibit_pos));
-          ibit_pos = (last_bits == 0) ? ibit_pos : (bits_per_block-(last_bits - ibit_pos));
+    if (n == 0)
+      return;
 
-          if ( (ibit_pos==0) && (last_bits == 0) )
-            continue;
-        }
-        else
-        {
-          ibit_pos -= last_bits;
-          // ibit_pos = last_bits + (bits_per_block - ibit_pos);
-        }
-        iblk_pos = 0;
-      }
+    kernels::rotate_inplace_blocks(m_bits.data(), m_num_bits, n);
+  }
 
-      if (iblk_pos == start_blk_pos)
-      {
-        block_type rblock{other.m_bits[iblk_pos]};
+  // The fast blockwise implementation of (right) rotate. The main body is
+  //  two straight runs of funnel shifts, one load pair, two shifts, one or
+  //  and one store per block, and the blocks at the seam and at the partial
+  //  tail are assembled separately.
+  NOINLINE void rotate(BitArray const &other, size_t n)
+  {
+    touch();
 
-        rblock = (ibit_pos == 0) ? 0 : rblock << (bits_per_block-ibit_pos);
+    if (&other == this)
+    {
+      rotate_inplace(n);
 
-        if (ibit_pos >= start_bit_pos)
-        {
-          if (last_bits == 0)
-          {
-            block |= rblock;
-          }
-          else
-          {
-            rblock &= (~static_cast<block_type>(0) >> (bits_per_block - last_bits));
-            block |= rblock;
-            block &= ~(~static_cast<block_type>(0) << last_bits);
-          }
-        }
-        else
-        {
-          block |= rblock;
+      return;
+    }
 
-          m_bits.at(opos) = block;
-          opos++;
+    assert(size() == other.size());
+    assert(m_bits.size() == other.m_bits.size());
 
-          assert(opos == num_blocks()-1);
+    if (n >= m_num_bits)
+      n %= m_num_bits;
 
-          block = other.m_bits[start_blk_pos];
+    if (n == 0)
+    {
+      *this = other;
 
-          block >>= ibit_pos;
-          block &= ~(~static_cast<block_type>(0) << last_bits);
-        }
-      }
-      else
-      {
-        block_type rblock{other.m_bits[iblk_pos]};
+      return;
+    }
+
+    kernels::rotate_blocks(kernels::simd_level::scalar, m_bits.data(), other.m_bits.data(), m_num_bits, n);
+    m_counter = other.m_counter;
+  }
+
+  // the vectorized (AVX2 / AVX-512) blockwise rotate, the instruction set is
+  //  chosen at runtime and the scalar 'rotate' is used when none is available
+  NOINLINE void rotate_simd(BitArray const &other, size_t n,
+                            kernels::simd_level level = kernels::cpu_simd_level())
+  {
+    touch();
+
+    assert(size() == other.size());
+    assert(m_bits.size() == other.m_bits.size());
+
+    level = kernels::clamp_simd_level(level);
+
+    if (level == kernels::simd_level::scalar)
+    {
+      rotate(other, n);
+
+      return;
+    }
+
+    if (n >= m_num_bits)
+      n %= m_num_bits;
 
-        rblock = (ibit_pos == 0) ? 0 : rblock << (bits_per_block-ibit_pos);
-        block |= rblock;
-      }
+    if (n == 0)
+    {
+      *this = other;
 
-      m_bits.at(opos) = block;
-      opos++;
+      return;
     }
+
+    kernels::rotate_blocks(level, m_bits.data(), other.m_bits.data(), m_num_bits, n);
+    m_counter = other.m_counter;
   }
 
   // the slow classical elementwise implementation of rotate
   NOINLINE void rotateRight(BitArray const &other, size_t n)
   {
+    touch();
+
     assert(size() == other.size());
     assert(m_bits.size() == other.m_bits.size());
 
@@ -313,77 +481,186 @@ public:
         set(i);
   }
 
-  // create the left neighbour bits, i.e., for each '1' bit
-  //  of the operand we set also the dt left bits in result
-  void createLeftNeighbourMask(BitArray const other, int dt)
+  // create the left neighbour bits, i.e., for each '1' bit at position t
+  //  of the operand we set also the bits t+1 .. t+dt in result
+  void createLeftNeighbourMask(BitArray const &other, int dt)
   {
-    m_bits            = other.m_bits;
-    m_num_bits        = other.m_num_bits;
-    m_bitset_capacity = other.m_bitset_capacity;
+    touch();
 
-    if ( (dt > 0) && (dt < int(bits_per_block)) )
+    if (dt <= 0)
     {
-      buffer_type  lbits = other.m_bits;
+      m_bits            = other.m_bits;
+      m_num_bits        = other.m_num_bits;
+      m_bitset_capacity = other.m_bitset_capacity;
+      m_counter         = other.m_counter;
 
-      for (int ir = 0; ir < dt; ir++)
-      {
-        size_type   const last = num_blocks() - 1;     // num_blocks() is >= 1
-        block_type *const b    = &lbits[0];
-        block_type  prev       = static_cast<block_type>(0);
-        block_type  newv;
+      return;
+    }
 
-        for (int i = last; i >= 0; --i)
-        {
-          newv = (b[i] << 1) | (prev >> (bits_per_block-1));
-          prev = b[i];
-          b[i] = newv;
-        }
+    assign_shape(other);
 
-        for (size_type i = 0; i <= last; ++i)
-        {
-          m_bits[i] |= b[i];
-        }
-      }
+    // the sparse trains are written as runs, when the source is another array
+    if ( (&other != this) && kernels::sparse_mask_pays(other.m_bits.data(), num_blocks(), size_t(dt)) )
+    {
+      m_counter.assign(kernels::sparse_mask(m_bits.data(), other.m_bits.data(), m_num_bits, size_t(dt), true));
 
-      m_count = recount();
+      return;
     }
+
+    store_blocks([&](auto emit)
+    {
+      kernels::dilate_left(other.m_bits.data(), m_num_bits, size_t(dt), emit);
+    });
   }
 
-  // create the right neighbour bits, i.e., for each '1' bit
-  //  of the operand we set also the dt right bits in result
-  void createRightNeighbourMask(BitArray const other, int dt)
+  // create the right neighbour bits, i.e., for each '1' bit at position t
+  //  of the operand we set also the bits t-dt .. t-1 in result
+  void createRightNeighbourMask(BitArray const &other, int dt)
   {
-    m_bits            = other.m_bits;
-    m_num_bits        = other.m_num_bits;
-    m_bitset_capacity = other.m_bitset_capacity;
+    touch();
 
-    // distance must be less than the half of the size
-    if ( (dt > 0) && (dt < int(bits_per_block)) )
+    if (dt <= 0)
     {
-      buffer_type rbits = other.m_bits;
+      m_bits            = other.m_bits;
+      m_num_bits        = other.m_num_bits;
+      m_bitset_capacity = other.m_bitset_capacity;
+      m_counter         = other.m_counter;
 
-      for (int ir = 0; ir < dt; ir++)
-      {
-        size_type   const last = num_blocks() - 1;     // num_blocks() is >= 1
-        block_type *const b    = &rbits[0];
-        block_type  prev       = static_cast<block_type>(0);
-        block_type  newv;
+      return;
+    }
 
-        for (size_type i = 0; i <= last; ++i)
-        {
-          newv = (b[i] >> 1) | (prev << (bits_per_block-1));
-          prev = b[i];
-          b[i] = newv;
-        }
+    assign_shape(other);
 
-        for (size_type i = 0; i <= last; ++i)
-        {
-          m_bits[i] |= b[i];
-        }
-      }
+    // the sparse trains are written as runs, when the source is another array
+    if ( (&other != this) && kernels::sparse_mask_pays(other.m_bits.data(), num_blocks(), size_t(dt)) )
+    {
+      m_counter.assign(kernels::sparse_mask(m_bits.data(), other.m_bits.data(), m_num_bits, size_t(dt), false));
+
+      return;
+    }
 
-      m_count = recount();
+    store_blocks([&](auto emit)
+    {
+      kernels::dilate_right(other.m_bits.data(), m_num_bits, size_t(dt), emit);
+    });
+  }
+
+  // create the circular left neighbour bits, the bits t+1 .. t+dt are taken
+  //  modulo size(), as the rotate does; dt may exceed size()
+  void createCircularLeftNeighbourMask(BitArray const &other, int dt)
+  {
+    touch();
+
+    if (dt <= 0)
+    {
+      m_bits            = other.m_bits;
+      m_num_bits        = other.m_num_bits;
+      m_bitset_capacity = other.m_bitset_capacity;
+      m_counter         = other.m_counter;
+
+      return;
+    }
+
+    assign_shape(other);
+
+    store_blocks([&](auto emit)
+    {
+      kernels::dilate_left_circular(other.m_bits.data(), m_num_bits, size_t(dt), emit);
+    });
+  }
+
+  // create the circular right neighbour bits, the bits t-dt .. t-1 are taken
+  //  modulo size()
+  void createCircularRightNeighbourMask(BitArray const &other, int dt)
+  {
+    touch();
+
+    if (dt <= 0)
+    {
+      m_bits            = other.m_bits;
+      m_num_bits        = other.m_num_bits;
+      m_bitset_capacity = other.m_bitset_capacity;
+      m_counter         = other.m_counter;
+
+      return;
     }
+
+    assign_shape(other);
+
+    store_blocks([&](auto emit)
+    {
+      kernels::dilate_right_circular(other.m_bits.data(), m_num_bits, size_t(dt), emit);
+    });
+  }
+
+  // create the left (right) neighbour bits from the sorted positions of the
+  //  '1' bits of a train of size() bits, e.g., as they come from a recording;
+  //  the cost follows the number of spikes and not the size
+  void createLeftNeighbourMask(std::span<uint32_t const> spikes, int dt)
+  {
+    touch();
+
+    m_counter.assign(kernels::sparse_mask(m_bits.data(), m_num_bits, spikes, size_t(std::max(dt, 0)), true));
+  }
+
+  void createRightNeighbourMask(std::span<uint32_t const> spikes, int dt)
+  {
+    touch();
+
+    m_counter.assign(kernels::sparse_mask(m_bits.data(), m_num_bits, spikes, size_t(std::max(dt, 0)), false));
+  }
+
+  // create the left lag window bits, i.e., for each '1' bit at position t
+  //  of the operand we set the bits t+dt_min .. t+dt_max in result, so a
+  //  dt_min above 0 excludes the exact synchrony
+  void createLeftLagMask(BitArray const &other, int dt_min, int dt_max)
+  {
+    assert( (0 <= dt_min) && (dt_min <= dt_max) );
+
+    touch();
+
+    block_type const *src = other.m_bits.data();
+
+    // the shifted source is read behind the output, so an alias is copied first
+    if (&other == this)
+    {
+      buffer_type &scratch = workspace_type::local().scratch(num_blocks());
+
+      std::copy(m_bits.begin(), m_bits.end(), scratch.begin());
+      src = scratch.data();
+    }
+    else
+      assign_shape(other);
+
+    store_blocks([&](auto emit)
+    {
+      kernels::dilate_left_lag(src, m_num_bits, size_t(dt_min), size_t(dt_max), emit);
+    });
+  }
+
+  // create the right lag window bits, the bits t-dt_max .. t-dt_min
+  void createRightLagMask(BitArray const &other, int dt_min, int dt_max)
+  {
+    assert( (0 <= dt_min) && (dt_min <= dt_max) );
+
+    touch();
+
+    block_type const *src = other.m_bits.data();
+
+    if (&other == this)
+    {
+      buffer_type &scratch = workspace_type::local().scratch(num_blocks());
+
+      std::copy(m_bits.begin(), m_bits.end(), scratch.begin());
+      src = scratch.data();
+    }
+    else
+      assign_shape(other);
+
+    store_blocks([&](auto emit)
+    {
+      kernels::dilate_right_lag(src, m_num_bits, size_t(dt_min), size_t(dt_max), emit);
+    });
   }
 
   [[nodiscard]] size_t size() const
@@ -403,6 +680,11 @@ public:
     return true;
   }
 
+  [[nodiscard]] block_type const *data() const noexcept
+  {
+    return m_bits.data();
+  }
+
   auto begin()
   {
     return m_bits.begin();
@@ -0,0 +1,1502 @@
+/**
+ * @file BitKernels.hpp
+ *
+ * @brief Block kernels shared by BitArray and StaticBitArray
+ *
+ * @ingroup neurolingo
+ *
+ * The kernels work on raw block buffers so that both the dynamic and
+ * the static bit array (and any other container of blocks) use the same
+ * code. The SIMD versions are compiled with function level target
+ * attributes and are selected at runtime from the CPUID information,
+ * so the binary does not need to be built with -mavx2 / -mavx512f.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_BITKERNELS_HPP
+#define BITARRAYFASTROTATE_BITKERNELS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NLG_SIMD_X86 1
+#include <immintrin.h>
+#define NLG_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NLG_SIMD_X86 0
+#define NLG_TARGET(isa)
+#endif /* __GNUC__ && __x86_64__ */
+
+namespace nlg::kernels {
+
+// the instruction sets we have kernels for, ordered by width
+enum class simd_level : int
+{
+  scalar = 0,
+  avx2   = 1,
+  avx512 = 2
+};
+
+inline simd_level detect_simd_level() noexcept
+{
+#if NLG_SIMD_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    return simd_level::avx512;
+
+  if (__builtin_cpu_supports("avx2"))
+    return simd_level::avx2;
+#endif /* NLG_SIMD_X86 */
+
+  return simd_level::scalar;
+}
+
+// the CPUID query runs once, the first time a kernel is dispatched
+inline simd_level cpu_simd_level() noexcept
+{
+  static simd_level const level = detect_simd_level();
+
+  return level;
+}
+
+// a requested level is never allowed to exceed what the cpu supports
+inline simd_level clamp_simd_level(simd_level requested) noexcept
+{
+  return std::min(requested, cpu_simd_level());
+}
+
+template <typename Block>
+inline constexpr std::size_t bits_of = std::numeric_limits<Block>::digits;
+
+// the 'n' lowest bits set, n < bits_of<Block>
+template <typename Block>
+constexpr Block low_mask(std::size_t n) noexcept
+{
+  return static_cast<Block>((Block(1) << n) - Block(1));
+}
+
+// the bits_of<Block> bits starting at bit position 'pos',
+//  the bits after the end of the buffer are read as zero
+template <typename Block>
+inline Block fetch_bits(Block const *src, std::size_t num_blocks, std::size_t pos) noexcept
+{
+  std::size_t const w = pos / bits_of<Block>;
+  std::size_t const r = pos % bits_of<Block>;
+
+  auto block = static_cast<Block>(src[w] >> r);
+
+  if ( (r != 0) && (w + 1 < num_blocks) )
+    block |= static_cast<Block>(src[w + 1] << (bits_of<Block> - r));
+
+  return block;
+}
+
+// the k-th output block of a right rotate by n (0 < n < num_bits) of the
+//  segment of 'num_bits' bits which starts at bit 'offset' of src, i.e.,
+//  out[i] = src[offset + (i + num_bits - n) % num_bits]; src_blocks is the
+//  number of readable blocks of src
+template <typename Block>
+inline Block rotated_segment_block(Block const *src, std::size_t src_blocks, std::size_t offset,
+                                   std::size_t num_bits, std::size_t n, std::size_t k) noexcept
+{
+  std::size_t const num_blocks = (num_bits - 1) / bits_of<Block> + 1;
+  std::size_t const pos        = (k * bits_of<Block> + num_bits - n) % num_bits;
+  std::size_t const run        = num_bits - pos;     // bits until the seam
+
+  Block block = fetch_bits(src, src_blocks, offset + pos);
+
+  if (run < bits_of<Block>)
+    block = static_cast<Block>((block & low_mask<Block>(run)) | (fetch_bits(src, src_blocks, offset) << run));
+
+  if ( (k == num_blocks - 1) && (num_bits % bits_of<Block> != 0) )
+    block &= low_mask<Block>(num_bits % bits_of<Block>);
+
+  return block;
+}
+
+// the k-th output block of a right rotate by n (0 < n < num_bits),
+//  i.e., out[i] = src[(i + num_bits - n) % num_bits]
+template <typename Block>
+inline Block rotated_block(Block const *src, std::size_t num_bits, std::size_t n, std::size_t k) noexcept
+{
+  return rotated_segment_block(src, (num_bits - 1) / bits_of<Block> + 1, 0, num_bits, n, k);
+}
+
+// write the 'num_bits' low bits of src (a block buffer) into dst starting at
+//  bit position 'pos'; the other bits of dst are left as they are
+template <typename Block>
+inline void deposit_bits(Block *dst, std::size_t pos, Block const *src, std::size_t num_bits) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t const first = pos / bpb;
+  std::size_t const last  = (pos + num_bits - 1) / bpb;
+  std::size_t const r     = pos % bpb;
+
+  auto merge = [&](std::size_t d, Block value)
+  {
+    std::size_t const lo   = (d == first) ? r : 0;
+    std::size_t const hi   = (d == last) ? (pos + num_bits - 1) % bpb + 1 : bpb;
+    Block const       mask = static_cast<Block>((hi == bpb ? ~Block(0) : low_mask<Block>(hi)) & ~low_mask<Block>(lo));
+
+    dst[d] = static_cast<Block>((dst[d] & ~mask) | (value & mask));
+  };
+
+  merge(first, static_cast<Block>(src[0] << r));
+
+  if (last == first)
+    return;
+
+  if (r == 0)
+    std::copy(src + 1, src + (last - first), dst + first + 1);
+  else
+    for (std::size_t d = first + 1; d < last; d++)
+      dst[d] = static_cast<Block>((src[d - first - 1] >> (bpb - r)) | (src[d - first] << r));
+
+  std::size_t const j = last - first;
+
+  merge(last, (r == 0) ? src[j] : static_cast<Block>((src[j - 1] >> (bpb - r)) | ((j * bpb < num_bits) ? src[j] << r : 0)));
+}
+
+// the number of set bits of a block buffer, one popcount per block
+template <typename Block>
+inline std::size_t popcount_scalar(Block const *src, std::size_t count) noexcept
+{
+  std::size_t _count = 0;
+
+  for (std::size_t i = 0; i < count; i++)
+    _count += std::popcount(src[i]);
+
+  return _count;
+}
+
+// the number of common set bits of two block buffers, one popcount per block
+template <typename Block>
+inline std::size_t popcount_and_scalar(Block const *a, Block const *b, std::size_t count) noexcept
+{
+  std::size_t _count = 0;
+
+  for (std::size_t i = 0; i < count; i++)
+    _count += std::popcount(static_cast<Block>(a[i] & b[i]));
+
+  return _count;
+}
+
+// carry save adder, (high, low) = a + b + c per bit
+template <typename Block>
+inline void csa(Block &high, Block &low, Block a, Block b, Block c) noexcept
+{
+  auto const u = static_cast<Block>(a ^ b);
+
+  high = static_cast<Block>((a & b) | (u & c));
+  low  = static_cast<Block>(u ^ c);
+}
+
+// the Harley-Seal popcount of the blocks load(0) .. load(count-1), a tree of
+//  carry save adders reduces 16 blocks to one 'sixteens' block, so there is
+//  one popcount per 16 blocks; it pays when popcount is not an instruction,
+//  e.g., a build without -mpopcnt
+template <typename Block, typename Load>
+inline std::size_t harley_seal(Load load, std::size_t count) noexcept
+{
+  Block       ones{0}, twos{0}, fours{0}, eights{0}, sixteens{0};
+  Block       twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+  std::size_t total = 0;
+  std::size_t i     = 0;
+
+  for (; i + 16 <= count; i += 16)
+  {
+    csa(twos_a, ones, ones, load(i + 0), load(i + 1));
+    csa(twos_b, ones, ones, load(i + 2), load(i + 3));
+    csa(fours_a, twos, twos, twos_a, twos_b);
+    csa(twos_a, ones, ones, load(i + 4), load(i + 5));
+    csa(twos_b, ones, ones, load(i + 6), load(i + 7));
+    csa(fours_b, twos, twos, twos_a, twos_b);
+    csa(eights_a, fours, fours, fours_a, fours_b);
+    csa(twos_a, ones, ones, load(i + 8), load(i + 9));
+    csa(twos_b, ones, ones, load(i + 10), load(i + 11));
+    csa(fours_a, twos, twos, twos_a, twos_b);
+    csa(twos_a, ones, ones, load(i + 12), load(i + 13));
+    csa(twos_b, ones, ones, load(i + 14), load(i + 15));
+    csa(fours_b, twos, twos, twos_a, twos_b);
+    csa(eights_b, fours, fours, fours_a, fours_b);
+    csa(sixteens, eights, eights, eights_a, eights_b);
+
+    total += std::popcount(sixteens);
+  }
+
+  total = 16 * total + 8 * std::popcount(eights) + 4 * std::popcount(fours) + 2 * std::popcount(twos) + std::popcount(ones);
+
+  for (; i < count; i++)
+    total += std::popcount(load(i));
+
+  return total;
+}
+
+template <typename Block>
+inline std::size_t popcount_harley_seal(Block const *src, std::size_t count) noexcept
+{
+  return harley_seal<Block>([src](std::size_t i) { return src[i]; }, count);
+}
+
+template <typename Block>
+inline std::size_t popcount_and_harley_seal(Block const *a, Block const *b, std::size_t count) noexcept
+{
+  return harley_seal<Block>([a, b](std::size_t i) { return static_cast<Block>(a[i] & b[i]); }, count);
+}
+
+// the fused three and four way counts, popcount(a & b & c [& d]) without
+//  the temporary intersection
+template <typename Block>
+inline std::size_t popcount_and3_harley_seal(Block const *a, Block const *b, Block const *c, std::size_t count) noexcept
+{
+  return harley_seal<Block>([a, b, c](std::size_t i) { return static_cast<Block>(a[i] & b[i] & c[i]); }, count);
+}
+
+template <typename Block>
+inline std::size_t popcount_and4_harley_seal(Block const *a, Block const *b, Block const *c, Block const *d,
+                                             std::size_t count) noexcept
+{
+  return harley_seal<Block>([a, b, c, d](std::size_t i) { return static_cast<Block>(a[i] & b[i] & c[i] & d[i]); }, count);
+}
+
+#if NLG_SIMD_X86
+
+inline bool detect_vpopcntdq() noexcept
+{
+  __builtin_cpu_init();
+
+  return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+}
+
+// the AVX-512 popcount instruction is an extension of its own, e.g., Ice
+//  Lake has it and Skylake-X has not, so it is detected apart from the level
+inline bool cpu_has_vpopcntdq() noexcept
+{
+  static bool const has = detect_vpopcntdq();
+
+  return has;
+}
+
+// the popcount of every byte by a lookup of its two nibbles (Mula)
+NLG_TARGET("avx2")
+inline __m256i popcount_bytes_avx2(__m256i v) noexcept
+{
+  __m256i const lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  __m256i const nibble = _mm256_set1_epi8(0x0f);
+  __m256i const lo     = _mm256_and_si256(v, nibble);
+  __m256i const hi     = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+
+  return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+}
+
+// the popcount of each of the four 64 bit lanes
+NLG_TARGET("avx2")
+inline __m256i popcount_lanes_avx2(__m256i v) noexcept
+{
+  return _mm256_sad_epu8(popcount_bytes_avx2(v), _mm256_setzero_si256());
+}
+
+NLG_TARGET("avx2")
+inline __m256i load_avx2(std::uint64_t const *src) noexcept
+{
+  return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src));
+}
+
+NLG_TARGET("avx2")
+inline void csa_avx2(__m256i &high, __m256i &low, __m256i a, __m256i b, __m256i c) noexcept
+{
+  __m256i const u = _mm256_xor_si256(a, b);
+
+  high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  low  = _mm256_xor_si256(u, c);
+}
+
+// the streams of the AVX2 tree, vector i holds the blocks 4i .. 4i+3
+struct blocks_avx2
+{
+  std::uint64_t const *src;
+
+  NLG_TARGET("avx2") __m256i operator()(std::size_t i) const noexcept
+  {
+    return load_avx2(src + 4 * i);
+  }
+};
+
+struct and_blocks_avx2
+{
+  std::uint64_t const *a;
+  std::uint64_t const *b;
+
+  NLG_TARGET("avx2") __m256i operator()(std::size_t i) const noexcept
+  {
+    return _mm256_and_si256(load_avx2(a + 4 * i), load_avx2(b + 4 * i));
+  }
+};
+
+struct and3_blocks_avx2
+{
+  std::uint64_t const *a;
+  std::uint64_t const *b;
+  std::uint64_t const *c;
+
+  NLG_TARGET("avx2") __m256i operator()(std::size_t i) const noexcept
+  {
+    return _mm256_and_si256(_mm256_and_si256(load_avx2(a + 4 * i), load_avx2(b + 4 * i)), load_avx2(c + 4 * i));
+  }
+};
+
+struct and4_blocks_avx2
+{
+  std::uint64_t const *a;
+  std::uint64_t const *b;
+  std::uint64_t const *c;
+  std::uint64_t const *d;
+
+  NLG_TARGET("avx2") __m256i operator()(std::size_t i) const noexcept
+  {
+    return _mm256_and_si256(_mm256_and_si256(load_avx2(a + 4 * i), load_avx2(b + 4 * i)),
+                            _mm256_and_si256(load_avx2(c + 4 * i), load_avx2(d + 4 * i)));
+  }
+};
+
+// the Harley-Seal tree on 16 vectors with the nibble lookup popcount of
+//  the 'sixteens', over the vectors load(0) .. load(num_vectors-1)
+template <typename Load>
+NLG_TARGET("avx2")
+inline std::size_t harley_seal_avx2(Load load, std::size_t num_vectors) noexcept
+{
+  __m256i     total  = _mm256_setzero_si256();
+  __m256i     ones   = _mm256_setzero_si256();
+  __m256i     twos   = _mm256_setzero_si256();
+  __m256i     fours  = _mm256_setzero_si256();
+  __m256i     eights = _mm256_setzero_si256();
+  __m256i     sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+  std::size_t i = 0;
+
+  for (; i + 16 <= num_vectors; i += 16)
+  {
+    csa_avx2(twos_a, ones, ones, load(i + 0), load(i + 1));
+    csa_avx2(twos_b, ones, ones, load(i + 2), load(i + 3));
+    csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+    csa_avx2(twos_a, ones, ones, load(i + 4), load(i + 5));
+    csa_avx2(twos_b, ones, ones, load(i + 6), load(i + 7));
+    csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+    csa_avx2(eights_a, fours, fours, fours_a, fours_b);
+    csa_avx2(twos_a, ones, ones, load(i + 8), load(i + 9));
+    csa_avx2(twos_b, ones, ones, load(i + 10), load(i + 11));
+    csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+    csa_avx2(twos_a, ones, ones, load(i + 12), load(i + 13));
+    csa_avx2(twos_b, ones, ones, load(i + 14), load(i + 15));
+    csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+    csa_avx2(eights_b, fours, fours, fours_a, fours_b);
+    csa_avx2(sixteens, eights, eights, eights_a, eights_b);
+
+    total = _mm256_add_epi64(total, popcount_lanes_avx2(sixteens));
+  }
+
+  total = _mm256_slli_epi64(total, 4);
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes_avx2(eights), 3));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes_avx2(fours), 2));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes_avx2(twos), 1));
+  total = _mm256_add_epi64(total, popcount_lanes_avx2(ones));
+
+  for (; i < num_vectors; i++)
+    total = _mm256_add_epi64(total, popcount_lanes_avx2(load(i)));
+
+  return static_cast<std::size_t>(_mm256_extract_epi64(total, 0)) + static_cast<std::size_t>(_mm256_extract_epi64(total, 1)) +
+         static_cast<std::size_t>(_mm256_extract_epi64(total, 2)) + static_cast<std::size_t>(_mm256_extract_epi64(total, 3));
+}
+
+NLG_TARGET("avx2")
+inline std::size_t popcount_avx2(std::uint64_t const *src, std::size_t count) noexcept
+{
+  std::size_t const num_vectors = count / 4;
+
+  return harley_seal_avx2(blocks_avx2{src}, num_vectors) + popcount_scalar(src + 4 * num_vectors, count % 4);
+}
+
+NLG_TARGET("avx2")
+inline std::size_t popcount_and_avx2(std::uint64_t const *a, std::uint64_t const *b, std::size_t count) noexcept
+{
+  std::size_t const num_vectors = count / 4;
+
+  return harley_seal_avx2(and_blocks_avx2{a, b}, num_vectors) +
+         popcount_and_scalar(a + 4 * num_vectors, b + 4 * num_vectors, count % 4);
+}
+
+NLG_TARGET("avx2")
+inline std::size_t popcount_and3_avx2(std::uint64_t const *a, std::uint64_t const *b, std::uint64_t const *c,
+                                      std::size_t count) noexcept
+{
+  std::size_t const num_vectors = count / 4;
+  std::size_t const tail        = 4 * num_vectors;
+
+  return harley_seal_avx2(and3_blocks_avx2{a, b, c}, num_vectors) +
+         popcount_and3_harley_seal(a + tail, b + tail, c + tail, count % 4);
+}
+
+NLG_TARGET("avx2")
+inline std::size_t popcount_and4_avx2(std::uint64_t const *a, std::uint64_t const *b, std::uint64_t const *c,
+                                      std::uint64_t const *d, std::size_t count) noexcept
+{
+  std::size_t const num_vectors = count / 4;
+  std::size_t const tail        = 4 * num_vectors;
+
+  return harley_seal_avx2(and4_blocks_avx2{a, b, c, d}, num_vectors) +
+         popcount_and4_harley_seal(a + tail, b + tail, c + tail, d + tail, count % 4);
+}
+
+// the sum of the 8 lanes; _mm512_reduce_add_epi64 and the unmasked shifts
+//  by a register of GCC 12 start from an undefined vector, which warns under
+//  -Wall (-Wmaybe-uninitialized), so the kernels use this sum and the maskz
+//  shifts
+NLG_TARGET("avx512f")
+inline std::uint64_t reduce_add_avx512(__m512i v) noexcept
+{
+  __m256i const half = _mm256_add_epi64(_mm512_maskz_extracti64x4_epi64(0xf, v, 0), _mm512_maskz_extracti64x4_epi64(0xf, v, 1));
+  __m128i const quad = _mm_add_epi64(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+
+  return static_cast<std::uint64_t>(_mm_cvtsi128_si64(quad)) + static_cast<std::uint64_t>(_mm_extract_epi64(quad, 1));
+}
+
+// one vpopcntq per 8 blocks, the tail is a masked load
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline std::size_t popcount_avx512(std::uint64_t const *src, std::size_t count) noexcept
+{
+  __m512i     total = _mm512_setzero_si512();
+  std::size_t i     = 0;
+
+  for (; i + 8 <= count; i += 8)
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512(src + i)));
+
+  if (i < count)
+  {
+    auto const tail = static_cast<__mmask8>((1u << (count - i)) - 1);
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, src + i)));
+  }
+
+  return static_cast<std::size_t>(reduce_add_avx512(total));
+}
+
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline std::size_t popcount_and_avx512(std::uint64_t const *a, std::uint64_t const *b, std::size_t count) noexcept
+{
+  __m512i     total = _mm512_setzero_si512();
+  std::size_t i     = 0;
+
+  for (; i + 8 <= count; i += 8)
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_and_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i))));
+
+  if (i < count)
+  {
+    auto const tail = static_cast<__mmask8>((1u << (count - i)) - 1);
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_and_si512(_mm512_maskz_loadu_epi64(tail, a + i), _mm512_maskz_loadu_epi64(tail, b + i))));
+  }
+
+  return static_cast<std::size_t>(reduce_add_avx512(total));
+}
+
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline std::size_t popcount_and3_avx512(std::uint64_t const *a, std::uint64_t const *b, std::uint64_t const *c,
+                                        std::size_t count) noexcept
+{
+  __m512i     total = _mm512_setzero_si512();
+  std::size_t i     = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m512i const v = _mm512_and_si512(_mm512_and_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)),
+                                       _mm512_loadu_si512(c + i));
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+  }
+
+  if (i < count)
+  {
+    auto const    tail = static_cast<__mmask8>((1u << (count - i)) - 1);
+    __m512i const v    = _mm512_and_si512(_mm512_and_si512(_mm512_maskz_loadu_epi64(tail, a + i), _mm512_maskz_loadu_epi64(tail, b + i)),
+                                          _mm512_maskz_loadu_epi64(tail, c + i));
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+  }
+
+  return static_cast<std::size_t>(reduce_add_avx512(total));
+}
+
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline std::size_t popcount_and4_avx512(std::uint64_t const *a, std::uint64_t const *b, std::uint64_t const *c,
+                                        std::uint64_t const *d, std::size_t count) noexcept
+{
+  __m512i     total = _mm512_setzero_si512();
+  std::size_t i     = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m512i const v = _mm512_and_si512(_mm512_and_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)),
+                                       _mm512_and_si512(_mm512_loadu_si512(c + i), _mm512_loadu_si512(d + i)));
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+  }
+
+  if (i < count)
+  {
+    auto const    tail = static_cast<__mmask8>((1u << (count - i)) - 1);
+    __m512i const v    = _mm512_and_si512(_mm512_and_si512(_mm512_maskz_loadu_epi64(tail, a + i), _mm512_maskz_loadu_epi64(tail, b + i)),
+                                          _mm512_and_si512(_mm512_maskz_loadu_epi64(tail, c + i), _mm512_maskz_loadu_epi64(tail, d + i)));
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+  }
+
+  return static_cast<std::size_t>(reduce_add_avx512(total));
+}
+
+#endif /* NLG_SIMD_X86 */
+
+// the number of set bits of a block buffer with the kernel of level, the
+//  AVX-512 level needs VPOPCNTDQ and falls back to AVX2 without it
+template <typename Block>
+inline std::size_t popcount(simd_level level, Block const *src, std::size_t count) noexcept
+{
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    level = clamp_simd_level(level);
+
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+      return popcount_avx512(src, count);
+
+    if (level != simd_level::scalar)
+      return popcount_avx2(src, count);
+  }
+#endif /* NLG_SIMD_X86 */
+
+  return popcount_harley_seal(src, count);
+}
+
+// the number of set bits of a block buffer
+template <typename Block>
+inline std::size_t popcount(Block const *src, std::size_t count) noexcept
+{
+  return popcount(cpu_simd_level(), src, count);
+}
+
+// the number of common set bits of two block buffers, i.e., popcount(a & b),
+//  with the kernel of level
+template <typename Block>
+inline std::size_t popcount_and(simd_level level, Block const *a, Block const *b, std::size_t count) noexcept
+{
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    level = clamp_simd_level(level);
+
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+      return popcount_and_avx512(a, b, count);
+
+    if (level != simd_level::scalar)
+      return popcount_and_avx2(a, b, count);
+  }
+#endif /* NLG_SIMD_X86 */
+
+  return popcount_and_harley_seal(a, b, count);
+}
+
+template <typename Block>
+inline std::size_t popcount_and(Block const *a, Block const *b, std::size_t count) noexcept
+{
+  return popcount_and(cpu_simd_level(), a, b, count);
+}
+
+// the number of set bits common to three block buffers, i.e.,
+//  popcount(a & b & c), e.g., the coincidences of a triplet
+template <typename Block>
+inline std::size_t popcount_and3(simd_level level, Block const *a, Block const *b, Block const *c,
+                                 std::size_t count) noexcept
+{
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    level = clamp_simd_level(level);
+
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+      return popcount_and3_avx512(a, b, c, count);
+
+    if (level != simd_level::scalar)
+      return popcount_and3_avx2(a, b, c, count);
+  }
+#endif /* NLG_SIMD_X86 */
+
+  return popcount_and3_harley_seal(a, b, c, count);
+}
+
+template <typename Block>
+inline std::size_t popcount_and3(Block const *a, Block const *b, Block const *c, std::size_t count) noexcept
+{
+  return popcount_and3(cpu_simd_level(), a, b, c, count);
+}
+
+// the number of set bits common to four block buffers
+template <typename Block>
+inline std::size_t popcount_and4(simd_level level, Block const *a, Block const *b, Block const *c, Block const *d,
+                                 std::size_t count) noexcept
+{
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    level = clamp_simd_level(level);
+
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+      return popcount_and4_avx512(a, b, c, d, count);
+
+    if (level != simd_level::scalar)
+      return popcount_and4_avx2(a, b, c, d, count);
+  }
+#endif /* NLG_SIMD_X86 */
+
+  return popcount_and4_harley_seal(a, b, c, d, count);
+}
+
+template <typename Block>
+inline std::size_t popcount_and4(Block const *a, Block const *b, Block const *c, Block const *d, std::size_t count) noexcept
+{
+  return popcount_and4(cpu_simd_level(), a, b, c, d, count);
+}
+
+// the basic counts of a pair of bit arrays, from which the similarity
+//  measures follow without another pass
+struct pair_stats
+{
+  std::size_t ones_a{0};    // |a|
+  std::size_t ones_b{0};    // |b|
+  std::size_t common{0};    // |a & b|
+  std::size_t differ{0};    // |a ^ b|, the Hamming distance
+
+  // |a & b| / |a | b|, 0 when both are empty
+  [[nodiscard]] double jaccard() const noexcept
+  {
+    std::size_t const either = common + differ;
+
+    return (either == 0) ? 0.0 : double(common) / double(either);
+  }
+
+  // |a & b| / sqrt(|a| |b|), 0 when one of them is empty
+  [[nodiscard]] double cosine() const noexcept
+  {
+    return ( (ones_a == 0) || (ones_b == 0) ) ? 0.0 : double(common) / std::sqrt(double(ones_a) * double(ones_b));
+  }
+
+  [[nodiscard]] double hamming() const noexcept
+  {
+    return double(differ);
+  }
+};
+
+// the pair counts of the chunked kernel are made on chunks of 1024 blocks
+//  (8 KiB per operand), which are still in L1 for the second and third count
+inline constexpr std::size_t pair_chunk_blocks = 1024;
+
+#if NLG_SIMD_X86
+
+// one step of 8 blocks of the pair counts, the lanes out of mask are
+//  loaded as zero
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline void popcount_pair_step_avx512(std::uint64_t const *a, std::uint64_t const *b, __mmask8 mask,
+                                      __m512i &total_a, __m512i &total_b, __m512i &total_ab) noexcept
+{
+  __m512i const va = _mm512_maskz_loadu_epi64(mask, a);
+  __m512i const vb = _mm512_maskz_loadu_epi64(mask, b);
+
+  total_a  = _mm512_add_epi64(total_a, _mm512_popcnt_epi64(va));
+  total_b  = _mm512_add_epi64(total_b, _mm512_popcnt_epi64(vb));
+  total_ab = _mm512_add_epi64(total_ab, _mm512_popcnt_epi64(_mm512_and_si512(va, vb)));
+}
+
+// |a|, |b| and |a & b| in one loop, three vpopcntq per 8 blocks
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline pair_stats popcount_pair_avx512(std::uint64_t const *a, std::uint64_t const *b, std::size_t count) noexcept
+{
+  __m512i     total_a  = _mm512_setzero_si512();
+  __m512i     total_b  = _mm512_setzero_si512();
+  __m512i     total_ab = _mm512_setzero_si512();
+  std::size_t i        = 0;
+
+  for (; i + 8 <= count; i += 8)
+    popcount_pair_step_avx512(a + i, b + i, __mmask8(0xff), total_a, total_b, total_ab);
+
+  if (i < count)
+    popcount_pair_step_avx512(a + i, b + i, static_cast<__mmask8>((1u << (count - i)) - 1), total_a, total_b, total_ab);
+
+  pair_stats stats;
+
+  stats.ones_a = static_cast<std::size_t>(reduce_add_avx512(total_a));
+  stats.ones_b = static_cast<std::size_t>(reduce_add_avx512(total_b));
+  stats.common = static_cast<std::size_t>(reduce_add_avx512(total_ab));
+  stats.differ = stats.ones_a + stats.ones_b - 2 * stats.common;
+
+  return stats;
+}
+
+#endif /* NLG_SIMD_X86 */
+
+// |a|, |b|, |a & b| and |a ^ b| in one pass over memory: with VPOPCNTDQ in
+//  one loop, otherwise the three counts of level run on each chunk of
+//  pair_chunk_blocks while it is in L1
+template <typename Block>
+inline pair_stats popcount_pair(simd_level level, Block const *a, Block const *b, std::size_t count) noexcept
+{
+  level = clamp_simd_level(level);
+
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+      return popcount_pair_avx512(a, b, count);
+  }
+#endif /* NLG_SIMD_X86 */
+
+  pair_stats stats;
+
+  for (std::size_t first = 0; first < count; first += pair_chunk_blocks)
+  {
+    std::size_t const n = std::min(pair_chunk_blocks, count - first);
+
+    stats.ones_a += popcount(level, a + first, n);
+    stats.ones_b += popcount(level, b + first, n);
+    stats.common += popcount_and(level, a + first, b + first, n);
+  }
+
+  stats.differ = stats.ones_a + stats.ones_b - 2 * stats.common;
+
+  return stats;
+}
+
+template <typename Block>
+inline pair_stats popcount_pair(Block const *a, Block const *b, std::size_t count) noexcept
+{
+  return popcount_pair(cpu_simd_level(), a, b, count);
+}
+
+#if NLG_SIMD_X86
+
+// one step of 8 blocks of the 4 x 4 block of pair counts, the lanes out of
+//  mask are loaded as zero
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline void popcount_and_4x4_step_avx512(std::uint64_t const *const a[4], std::uint64_t const *const b[4],
+                                         std::size_t i, __mmask8 mask, __m512i (&sums)[16]) noexcept
+{
+  __m512i av[4], bv[4];
+
+  for (int r = 0; r < 4; r++)
+  {
+    av[r] = _mm512_maskz_loadu_epi64(mask, a[r] + i);
+    bv[r] = _mm512_maskz_loadu_epi64(mask, b[r] + i);
+  }
+
+  for (int r = 0; r < 4; r++)
+    for (int c = 0; c < 4; c++)
+      sums[4 * r + c] = _mm512_add_epi64(sums[4 * r + c], _mm512_popcnt_epi64(_mm512_and_si512(av[r], bv[c])));
+}
+
+// the 4 x 4 block of pair counts with AVX-512 VPOPCNTDQ, each loaded vector
+//  is used four times and the 16 sums stay in registers
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline void popcount_and_4x4_avx512(std::uint64_t const *const a[4], std::uint64_t const *const b[4],
+                                    std::size_t count, std::size_t acc[16]) noexcept
+{
+  __m512i     sums[16];
+  std::size_t i = 0;
+
+  for (auto &sum : sums)
+    sum = _mm512_setzero_si512();
+
+  for (; i + 8 <= count; i += 8)
+    popcount_and_4x4_step_avx512(a, b, i, __mmask8(0xff), sums);
+
+  if (i < count)
+    popcount_and_4x4_step_avx512(a, b, i, static_cast<__mmask8>((1u << (count - i)) - 1), sums);
+
+  for (int k = 0; k < 16; k++)
+    acc[k] += static_cast<std::size_t>(reduce_add_avx512(sums[k]));
+}
+
+#endif /* NLG_SIMD_X86 */
+
+// whether popcount_and_4x4 is register blocked at level, i.e., AVX-512
+//  VPOPCNTDQ on 64 bit blocks; a blocked Harley-Seal would need the four
+//  carry vectors of each of the 16 sums, more than the 16 AVX2 registers,
+//  so the callers count their pairs one by one with popcount_and instead
+template <typename Block>
+inline bool has_blocked_popcount_and_4x4(simd_level level) noexcept
+{
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+    return (clamp_simd_level(level) == simd_level::avx512) && cpu_has_vpopcntdq();
+#endif /* NLG_SIMD_X86 */
+
+  return false;
+}
+
+// acc[4*r + c] += popcount(a[r] & b[c]) over count blocks, the micro kernel
+//  of the Gram matrix; when it is not blocked (see above) it is 16 calls of
+//  popcount_and
+template <typename Block>
+inline void popcount_and_4x4(simd_level level, Block const *const a[4], Block const *const b[4],
+                             std::size_t count, std::size_t acc[16]) noexcept
+{
+  level = clamp_simd_level(level);
+
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+    {
+      popcount_and_4x4_avx512(a, b, count, acc);
+
+      return;
+    }
+  }
+#endif /* NLG_SIMD_X86 */
+
+  for (int r = 0; r < 4; r++)
+    for (int c = 0; c < 4; c++)
+      acc[4 * r + c] += popcount_and(level, a[r], b[c], count);
+}
+
+// dst[i] = funnel shift of the pair (src[i], src[i+1]) by r bits, i in [0, count)
+//  src[count] must be readable when r != 0
+template <typename Block>
+inline void shift_copy_scalar(Block *dst, Block const *src, std::size_t count, std::size_t r) noexcept
+{
+  if (r == 0)
+  {
+    std::copy_n(src, count, dst);
+
+    return;
+  }
+
+  for (std::size_t i = 0; i < count; i++)
+    dst[i] = static_cast<Block>((src[i] >> r) | (src[i + 1] << (bits_of<Block> - r)));
+}
+
+#if NLG_SIMD_X86
+
+NLG_TARGET("avx2")
+inline void shift_copy_avx2(std::uint64_t *dst, std::uint64_t const *src, std::size_t count, std::size_t r) noexcept
+{
+  if (r == 0)
+  {
+    std::copy_n(src, count, dst);
+
+    return;
+  }
+
+  __m128i const     rcount = _mm_cvtsi32_si128(static_cast<int>(r));
+  __m128i const     lcount = _mm_cvtsi32_si128(static_cast<int>(64 - r));
+  std::size_t       i      = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256i const lo = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i));
+    __m256i const hi = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i + 1));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_or_si256(_mm256_srl_epi64(lo, rcount), _mm256_sll_epi64(hi, lcount)));
+  }
+
+  shift_copy_scalar(dst + i, src + i, count - i, r);
+}
+
+NLG_TARGET("avx512f")
+inline void shift_copy_avx512(std::uint64_t *dst, std::uint64_t const *src, std::size_t count, std::size_t r) noexcept
+{
+  if (r == 0)
+  {
+    std::copy_n(src, count, dst);
+
+    return;
+  }
+
+  __m128i const     rcount = _mm_cvtsi32_si128(static_cast<int>(r));
+  __m128i const     lcount = _mm_cvtsi32_si128(static_cast<int>(64 - r));
+  std::size_t       i      = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m512i const lo = _mm512_loadu_si512(src + i);
+    __m512i const hi = _mm512_loadu_si512(src + i + 1);
+
+    _mm512_storeu_si512(dst + i, _mm512_or_si512(_mm512_maskz_srl_epi64(0xff, lo, rcount), _mm512_maskz_sll_epi64(0xff, hi, lcount)));
+  }
+
+  shift_copy_scalar(dst + i, src + i, count - i, r);
+}
+
+#endif /* NLG_SIMD_X86 */
+
+template <typename Block>
+inline void shift_copy(simd_level level, Block *dst, Block const *src, std::size_t count, std::size_t r) noexcept
+{
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    switch (level)
+    {
+      case simd_level::avx512: shift_copy_avx512(dst, src, count, r); return;
+      case simd_level::avx2:   shift_copy_avx2(dst, src, count, r);   return;
+      default:                 break;
+    }
+  }
+#endif /* NLG_SIMD_X86 */
+
+  (void)level;
+  shift_copy_scalar(dst, src, count, r);
+}
+
+// one straight run of a rotate, the output blocks [dst, dst + count) are the
+//  funnel shifts by r of the source block pairs starting at [src, src + count)
+struct rotate_run
+{
+  std::size_t dst;
+  std::size_t src;
+  std::size_t count;
+  std::size_t r;
+};
+
+// The layout of a right rotate of 'num_bits' bits by n (0 < n < num_bits),
+//  the source bits start at bit position 'offset' of the source buffer.
+//  The output is split in two straight runs of funnel shifts, the blocks
+//  which take their bits from [num_bits-n, num_bits) and the blocks which
+//  take their bits from [0, num_bits-n), plus at most two blocks at the seam
+//  and at the partial tail which are assembled by rotated_block.
+struct rotate_plan
+{
+  rotate_run  runs[2];
+  std::size_t fixups[2];
+  std::size_t num_fixups;
+};
+
+template <typename Block>
+constexpr rotate_plan make_rotate_plan(std::size_t num_bits, std::size_t n, std::size_t offset = 0) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t const num_blocks = (num_bits - 1) / bpb + 1;
+  std::size_t const start      = num_bits - n;
+  std::size_t const head       = n / bpb;                // output bits [0, n) come from [start, num_bits)
+  std::size_t const tail_beg   = (n + bpb - 1) / bpb;    // output bits [n, num_bits) come from [0, start)
+  std::size_t const tail_end   = std::max(num_bits / bpb, tail_beg);
+  bool const        seam       = (n % bpb) != 0;
+
+  std::size_t const head_pos   = offset + start;
+  std::size_t const tail_pos   = offset + tail_beg * bpb - n;
+
+  rotate_plan plan{{{0, head_pos / bpb, head, head_pos % bpb},
+                    {tail_beg, tail_pos / bpb, tail_end - tail_beg, tail_pos % bpb}},
+                   {0, 0}, 0};
+
+  if (seam)
+    plan.fixups[plan.num_fixups++] = head;
+
+  if ( (num_bits % bpb != 0) && !(seam && (head == num_blocks - 1)) )
+    plan.fixups[plan.num_fixups++] = num_blocks - 1;
+
+  return plan;
+}
+
+// the pair (lo, hi) as one word of two blocks shifted left (right) by s,
+//  0 < s < 2 * bits_of<Block>
+template <typename Block>
+inline void shift_left_pair(Block &lo, Block &hi, std::size_t s) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  if (s < bpb)
+  {
+    hi = static_cast<Block>((hi << s) | (lo >> (bpb - s)));
+    lo = static_cast<Block>(lo << s);
+  }
+  else
+  {
+    hi = static_cast<Block>(lo << (s - bpb));
+    lo = 0;
+  }
+}
+
+template <typename Block>
+inline void shift_right_pair(Block &lo, Block &hi, std::size_t s) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  if (s < bpb)
+  {
+    lo = static_cast<Block>((lo >> s) | (hi << (bpb - s)));
+    hi = static_cast<Block>(hi >> s);
+  }
+  else
+  {
+    lo = static_cast<Block>(hi >> (s - bpb));
+    hi = 0;
+  }
+}
+
+// right rotate of a train of one or two blocks by n (0 < n < num_bits),
+//  the bits are rotated as one word, (v << n) | (v >> (num_bits - n)),
+//  without the plan and the runs which cost more than the blocks here
+template <typename Block>
+inline void rotate_blocks_small(Block *dst, Block const *src, std::size_t num_bits, std::size_t n) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  assert( (n > 0) && (n < num_bits) && (num_bits <= 2 * bpb) );
+
+  if (num_bits <= bpb)
+  {
+    Block const mask = (num_bits == bpb) ? static_cast<Block>(~Block(0)) : low_mask<Block>(num_bits);
+    Block const v    = static_cast<Block>(src[0] & mask);
+
+    dst[0] = static_cast<Block>(((v << n) | (v >> (num_bits - n))) & mask);
+
+    return;
+  }
+
+  Block const mask = (num_bits == 2 * bpb) ? static_cast<Block>(~Block(0)) : low_mask<Block>(num_bits - bpb);
+  Block       lo   = src[0];
+  Block       hi   = static_cast<Block>(src[1] & mask);
+  Block       lo_r = lo;
+  Block       hi_r = hi;
+
+  shift_left_pair(lo, hi, n);
+  shift_right_pair(lo_r, hi_r, num_bits - n);
+
+  dst[0] = static_cast<Block>(lo | lo_r);
+  dst[1] = static_cast<Block>((hi | hi_r) & mask);
+}
+
+// right rotate of 'num_bits' bits by n (0 < n < num_bits) from src to dst
+template <typename Block>
+inline void rotate_blocks(simd_level level, Block *dst, Block const *src, std::size_t num_bits, std::size_t n) noexcept
+{
+  assert( (n > 0) && (n < num_bits) );
+  assert(dst != src);
+
+  if (num_bits <= 2 * bits_of<Block>)
+  {
+    rotate_blocks_small(dst, src, num_bits, n);
+
+    return;
+  }
+
+  rotate_plan const plan = make_rotate_plan<Block>(num_bits, n);
+
+  for (rotate_run const &run : plan.runs)
+    shift_copy(level, dst + run.dst, src + run.src, run.count, run.r);
+
+  for (std::size_t i = 0; i < plan.num_fixups; i++)
+    dst[plan.fixups[i]] = rotated_block(src, num_bits, n, plan.fixups[i]);
+}
+
+// right rotate by n (0 < n < num_bits) when num_bits is a multiple of the
+//  block size; there is no partial tail, and the seam is the single block
+//  which takes its bits from the last and the first source block
+template <typename Block>
+inline void rotate_blocks_aligned(simd_level level, Block *dst, Block const *src, std::size_t num_blocks, std::size_t n) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  assert( (n > 0) && (n < num_blocks * bpb) );
+  assert(dst != src);
+
+  std::size_t const start = num_blocks * bpb - n;
+  std::size_t const w     = start / bpb;
+  std::size_t const r     = start % bpb;
+  std::size_t const seam  = num_blocks - w - 1;
+
+  shift_copy(level, dst, src + w, seam, r);
+
+  dst[seam] = (r == 0) ? src[num_blocks - 1]
+                       : static_cast<Block>((src[num_blocks - 1] >> r) | (src[0] << (bpb - r)));
+
+  shift_copy(level, dst + seam + 1, src, w, r);
+}
+
+// the funnel shift copy with the shift known at compile time
+template <std::size_t R, typename Block>
+inline void shift_copy_fixed(Block *dst, Block const *src, std::size_t count) noexcept
+{
+  if constexpr (R == 0)
+  {
+    std::copy_n(src, count, dst);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < count; i++)
+      dst[i] = static_cast<Block>((src[i] >> R) | (src[i + 1] << (bits_of<Block> - R)));
+  }
+}
+
+// right rotate with both the size and the shift (0 < N < NumBits) known at
+//  compile time, so all the run lengths, the shifts and the seam handling
+//  are constants and the loops can be fully unrolled
+template <std::size_t NumBits, std::size_t N, typename Block>
+inline void rotate_blocks_fixed(Block *dst, Block const *src) noexcept
+{
+  constexpr std::size_t bpb        = bits_of<Block>;
+  constexpr std::size_t num_blocks = (NumBits - 1) / bpb + 1;
+  constexpr std::size_t start      = NumBits - N;
+
+  static_assert( (N > 0) && (N < NumBits) );
+
+  if constexpr (NumBits % bpb == 0)
+  {
+    constexpr std::size_t w    = start / bpb;
+    constexpr std::size_t r    = start % bpb;
+    constexpr std::size_t seam = num_blocks - w - 1;
+
+    shift_copy_fixed<r>(dst, src + w, seam);
+
+    if constexpr (r == 0)
+      dst[seam] = src[num_blocks - 1];
+    else
+      dst[seam] = static_cast<Block>((src[num_blocks - 1] >> r) | (src[0] << (bpb - r)));
+
+    shift_copy_fixed<r>(dst + seam + 1, src, w);
+  }
+  else
+  {
+    constexpr std::size_t head     = N / bpb;
+    constexpr std::size_t tail_beg = (N + bpb - 1) / bpb;
+    constexpr std::size_t tail_end = NumBits / bpb;
+    constexpr bool        seam     = (N % bpb) != 0;
+
+    shift_copy_fixed<start % bpb>(dst, src + start / bpb, head);
+
+    if constexpr (tail_beg < tail_end)
+      shift_copy_fixed<(bpb - N % bpb) % bpb>(dst + tail_beg, src + (tail_beg * bpb - N) / bpb, tail_end - tail_beg);
+
+    if constexpr (seam)
+      dst[head] = rotated_block(src, NumBits, N, head);
+
+    if constexpr (!(seam && (head == num_blocks - 1)))
+      dst[num_blocks - 1] = rotated_block(src, NumBits, N, num_blocks - 1);
+  }
+}
+
+// in place right rotate of 'num_bits' bits by n (0 < n < num_bits).
+//  The padded buffer of L = num_blocks * bits_per_block bits is first rotated
+//  by the whole blocks of m = n + (L - num_bits) with std::rotate. One pass
+//  then moves the bits by the remainder r = m % bits_per_block and closes the
+//  gap of the padding bits at the same time: output bit i is B[(i - r) mod L]
+//  for i < n (the head) and B[i + gap - r] for i >= n (the tail), B being the
+//  blocks after std::rotate. The head reads the blocks below it and runs
+//  downwards; the tail reads the blocks below it when gap < r (downwards)
+//  and the blocks above it otherwise (upwards, with the vectorized funnel
+//  shift), so no block is read after it has been written.
+//
+//  Each block is read and written once by the pass, plus std::rotate when
+//  m >= bits_per_block. A single pass is not possible without a second
+//  buffer: a funnel shift needs both neighbours of a source block in their
+//  original state, and a cycle-leader walk over the blocks overwrites the
+//  neighbour before it is read whenever the walk has fewer cycles than blocks.
+template <typename Block>
+inline void rotate_inplace_blocks(Block *bits, std::size_t num_bits, std::size_t n) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  assert( (n > 0) && (n < num_bits) );
+
+  std::size_t const num_blocks = (num_bits - 1) / bpb + 1;
+  std::size_t const gap        = num_blocks * bpb - num_bits;
+  std::size_t const m          = n + gap;
+  std::size_t const q          = m / bpb;
+  std::size_t const r          = m % bpb;
+
+  if (q != 0)
+    std::rotate(bits, bits + num_blocks - q, bits + num_blocks);
+
+  if ( (r == 0) && (gap == 0) )
+    return;
+
+  Block const       top       = bits[num_blocks - 1];    // the wrap of the head, the pass may overwrite it
+  std::size_t const boundary  = n / bpb;                 // the block where the tail starts
+  Block const       head_mask = low_mask<Block>(n % bpb);
+
+  // bits[k] = bits[k] << e with the high bits of bits[k-1], for k = last .. first + 1
+  auto shift_up = [bits](std::size_t first, std::size_t last, std::size_t e)
+  {
+    for (std::size_t k = last; k > first; k--)
+      bits[k] = static_cast<Block>((bits[k] << e) | (bits[k - 1] >> (bpb - e)));
+  };
+
+  Block const prev       = (boundary == 0) ? top : bits[boundary - 1];
+  Block const head_block = (r == 0) ? bits[boundary] : static_cast<Block>((bits[boundary] << r) | (prev >> (bpb - r)));
+  Block       tail_block;
+
+  if (gap < r)
+  {
+    // the tail reads the blocks below it, the bits below block 0 fall in the head
+    std::size_t const e = r - gap;
+
+    tail_block = static_cast<Block>((bits[boundary] << e) | (((boundary == 0) ? Block(0) : prev) >> (bpb - e)));
+
+    if (boundary + 1 < num_blocks)
+      shift_up(boundary, num_blocks - 1, e);
+  }
+  else
+  {
+    // the tail reads the blocks above it
+    std::size_t const d = gap - r;
+
+    if (d == 0)
+      tail_block = bits[boundary];
+    else
+    {
+      Block const next = (boundary + 1 < num_blocks) ? bits[boundary + 1] : Block(0);
+
+      tail_block = static_cast<Block>((bits[boundary] >> d) | (next << (bpb - d)));
+
+      if (boundary + 1 < num_blocks)
+      {
+        shift_copy(cpu_simd_level(), bits + boundary + 1, bits + boundary + 1, num_blocks - boundary - 2, d);
+        bits[num_blocks - 1] = static_cast<Block>(bits[num_blocks - 1] >> d);
+      }
+    }
+  }
+
+  bits[boundary] = static_cast<Block>((head_block & head_mask) | (tail_block & ~head_mask));
+
+  if ( (r != 0) && (boundary > 0) )
+  {
+    shift_up(0, boundary - 1, r);
+    bits[0] = static_cast<Block>((bits[0] << r) | (top >> (bpb - r)));
+  }
+
+  if (num_bits % bpb != 0)
+    bits[num_blocks - 1] &= low_mask<Block>(num_bits % bpb);
+}
+
+// in place right rotate by n (0 < n < num_bits) of the segment of 'num_bits'
+//  bits which starts at bit 'offset' of bits (num_blocks readable blocks).
+//  The rotated segment is assembled in scratch, which must hold the blocks
+//  of the segment, with the two straight runs and the fixups of the plan,
+//  and is then written back. Segments which start and end on a block
+//  boundary are rotated directly in place.
+template <typename Block>
+inline void rotate_segment_inplace(simd_level level, Block *bits, std::size_t num_blocks, std::size_t offset,
+                                   std::size_t num_bits, std::size_t n, Block *scratch) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  assert( (n > 0) && (n < num_bits) );
+
+  if ( (offset % bpb == 0) && (num_bits % bpb == 0) )
+  {
+    rotate_inplace_blocks(bits + offset / bpb, num_bits, n);
+
+    return;
+  }
+
+  rotate_plan const plan = make_rotate_plan<Block>(num_bits, n, offset);
+
+  for (rotate_run const &run : plan.runs)
+    shift_copy(level, scratch + run.dst, bits + run.src, run.count, run.r);
+
+  for (std::size_t i = 0; i < plan.num_fixups; i++)
+    scratch[plan.fixups[i]] = rotated_segment_block(bits, num_blocks, offset, num_bits, n, plan.fixups[i]);
+
+  deposit_bits(bits, offset, scratch, num_bits);
+}
+
+// the Harley-Seal count of popcount(a[i] & funnel shift of (src[i], src[i+1])
+//  by r), 0 < r < bits_of<Block>
+template <typename Block>
+inline std::size_t popcount_and_shifted_harley_seal(Block const *a, Block const *src, std::size_t count,
+                                                    std::size_t r) noexcept
+{
+  return harley_seal<Block>([a, src, r](std::size_t i)
+                            {
+                              return static_cast<Block>(a[i] & ((src[i] >> r) | (src[i + 1] << (bits_of<Block> - r))));
+                            }, count);
+}
+
+#if NLG_SIMD_X86
+
+// the AVX2 stream of a & the funnel shifted source, vector i holds the
+//  blocks 4i .. 4i+3
+struct and_shifted_blocks_avx2
+{
+  std::uint64_t const *a;
+  std::uint64_t const *src;
+  __m128i              rcount;
+  __m128i              lcount;
+
+  NLG_TARGET("avx2") __m256i operator()(std::size_t i) const noexcept
+  {
+    __m256i const shifted = _mm256_or_si256(_mm256_srl_epi64(load_avx2(src + 4 * i), rcount),
+                                            _mm256_sll_epi64(load_avx2(src + 4 * i + 1), lcount));
+
+    return _mm256_and_si256(load_avx2(a + 4 * i), shifted);
+  }
+};
+
+NLG_TARGET("avx2")
+inline std::size_t popcount_and_shifted_avx2(std::uint64_t const *a, std::uint64_t const *src, std::size_t count,
+                                             std::size_t r) noexcept
+{
+  std::size_t const num_vectors = count / 4;
+  std::size_t const tail        = 4 * num_vectors;
+
+  and_shifted_blocks_avx2 const load{a, src, _mm_cvtsi32_si128(static_cast<int>(r)),
+                                     _mm_cvtsi32_si128(static_cast<int>(64 - r))};
+
+  return harley_seal_avx2(load, num_vectors) + popcount_and_shifted_harley_seal(a + tail, src + tail, count % 4, r);
+}
+
+// one vpopcntq per 8 blocks, the tail is a masked load of both operands
+NLG_TARGET("avx512f,avx512vpopcntdq")
+inline std::size_t popcount_and_shifted_avx512(std::uint64_t const *a, std::uint64_t const *src, std::size_t count,
+                                               std::size_t r) noexcept
+{
+  __m128i const rcount = _mm_cvtsi32_si128(static_cast<int>(r));
+  __m128i const lcount = _mm_cvtsi32_si128(static_cast<int>(64 - r));
+  __m512i       total  = _mm512_setzero_si512();
+  std::size_t   i      = 0;
+
+  for (; i < count; i += 8)
+  {
+    auto const    mask    = (i + 8 <= count) ? __mmask8(0xff) : static_cast<__mmask8>((1u << (count - i)) - 1);
+    __m512i const shifted = _mm512_or_si512(_mm512_maskz_srl_epi64(mask, _mm512_maskz_loadu_epi64(mask, src + i), rcount),
+                                            _mm512_maskz_sll_epi64(mask, _mm512_maskz_loadu_epi64(mask, src + i + 1), lcount));
+
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_and_si512(_mm512_maskz_loadu_epi64(mask, a + i), shifted)));
+  }
+
+  return static_cast<std::size_t>(reduce_add_avx512(total));
+}
+
+#endif /* NLG_SIMD_X86 */
+
+// sum of popcount(a[i] & funnel shift of (src[i], src[i+1]) by r), i in [0, count)
+//  with the kernel of level; src[count] must be readable when r != 0
+template <typename Block>
+inline std::size_t popcount_and_shifted(simd_level level, Block const *a, Block const *src, std::size_t count,
+                                        std::size_t r) noexcept
+{
+  if (r == 0)
+    return popcount_and(level, a, src, count);
+
+#if NLG_SIMD_X86
+  if constexpr (std::is_same_v<Block, std::uint64_t>)
+  {
+    level = clamp_simd_level(level);
+
+    if ( (level == simd_level::avx512) && cpu_has_vpopcntdq() )
+      return popcount_and_shifted_avx512(a, src, count, r);
+
+    if (level != simd_level::scalar)
+      return popcount_and_shifted_avx2(a, src, count, r);
+  }
+#endif /* NLG_SIMD_X86 */
+
+  return popcount_and_shifted_harley_seal(a, src, count, r);
+}
+
+// popcount(a & rotate(src, n)) for 0 < n < num_bits, with the same plan
+//  as rotate_blocks but without writing the rotated blocks anywhere
+template <typename Block>
+inline std::size_t popcount_and_rotated(simd_level level, Block const *a, Block const *src, std::size_t num_bits,
+                                        std::size_t n) noexcept
+{
+  assert( (n > 0) && (n < num_bits) );
+
+  rotate_plan const plan   = make_rotate_plan<Block>(num_bits, n);
+  std::size_t       _count = 0;
+
+  for (rotate_run const &run : plan.runs)
+    _count += popcount_and_shifted(level, a + run.dst, src + run.src, run.count, run.r);
+
+  for (std::size_t i = 0; i < plan.num_fixups; i++)
+    _count += std::popcount(static_cast<Block>(a[plan.fixups[i]] & rotated_block(src, num_bits, n, plan.fixups[i])));
+
+  return _count;
+}
+
+template <typename Block>
+inline std::size_t popcount_and_rotated(Block const *a, Block const *src, std::size_t num_bits, std::size_t n) noexcept
+{
+  return popcount_and_rotated(cpu_simd_level(), a, src, num_bits, n);
+}
+
+// K right rotates of one source into the rows of a matrix (row r starts at
+//  dst + r * stride) in one pass over the source: the source is walked in
+//  tiles and every row takes the part of its two runs which reads the tile,
+//  so each tile is loaded once and reused by all the rows while it is hot
+template <typename Block>
+inline void rotate_batch(simd_level level, Block *dst, std::size_t stride, Block const *src,
+                         std::size_t num_bits, std::size_t const *shifts, std::size_t num_shifts) noexcept
+{
+  constexpr std::size_t tile = 1024;   // 8KB of 64-bit blocks
+
+  std::size_t const num_blocks = (num_bits - 1) / bits_of<Block> + 1;
+
+  for (std::size_t b0 = 0; b0 < num_blocks; b0 += tile)
+  {
+    std::size_t const b1 = std::min(num_blocks, b0 + tile);
+
+    for (std::size_t k = 0; k < num_shifts; k++)
+    {
+      std::size_t const n   = shifts[k] % num_bits;
+      Block *const      row = dst + k * stride;
+
+      if (n == 0)
+      {
+        std::copy(src + b0, src + b1, row + b0);
+
+        continue;
+      }
+
+      rotate_plan const plan = make_rotate_plan<Block>(num_bits, n);
+
+      for (rotate_run const &run : plan.runs)
+      {
+        std::size_t const lo = std::max(run.src, b0);
+        std::size_t const hi = std::min(run.src + run.count, b1);
+
+        if (lo < hi)
+          shift_copy(level, row + run.dst + (lo - run.src), src + lo, hi - lo, run.r);
+      }
+    }
+  }
+
+  for (std::size_t k = 0; k < num_shifts; k++)
+  {
+    std::size_t const n = shifts[k] % num_bits;
+
+    if (n == 0)
+      continue;
+
+    rotate_plan const plan = make_rotate_plan<Block>(num_bits, n);
+
+    for (std::size_t i = 0; i < plan.num_fixups; i++)
+      dst[k * stride + plan.fixups[i]] = rotated_block(src, num_bits, n, plan.fixups[i]);
+  }
+}
+
+}  // namespace nlg::kernels
+
+#endif //BITARRAYFASTROTATE_BITKERNELS_HPP
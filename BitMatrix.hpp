@@ -0,0 +1,201 @@
+/**
+ * @file BitMatrix.hpp
+ *
+ * @brief Contiguous matrix of equal sized bit rows (surrogates, rasters)
+ *
+ * @ingroup neurolingo
+ *
+ * All the rows live in one heap buffer aligned to the cache line, and every
+ * row starts on a cache line, i.e., the row stride is the number of blocks
+ * rounded up to a whole cache line. The padding blocks are always zero.
+ * The bit layout of a row is the same as the one of BitArray, so the
+ * kernels of BitKernels.hpp work on the rows directly.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_BITMATRIX_HPP
+#define BITARRAYFASTROTATE_BITMATRIX_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <memory>
+#include <limits>
+#include <new>
+#include <span>
+#include <vector>
+#include <bit>
+
+#include "BitKernels.hpp"
+
+namespace nlg {
+
+inline constexpr size_t cache_line_size = 64;
+
+// allocator which aligns the buffers to the cache line
+template <typename T>
+struct CacheAlignedAllocator
+{
+  using value_type = T;
+
+  CacheAlignedAllocator() noexcept = default;
+
+  template <typename U>
+  explicit CacheAlignedAllocator(CacheAlignedAllocator<U> const &) noexcept {}
+
+  T *allocate(size_t n)
+  {
+    return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{cache_line_size}));
+  }
+
+  void deallocate(T *p, [[maybe_unused]] size_t n) noexcept
+  {
+    ::operator delete(p, std::align_val_t{cache_line_size});
+  }
+
+  template <typename U>
+  bool operator==(CacheAlignedAllocator<U> const &) const noexcept { return true; }
+};
+
+template <typename Block=std::uint64_t>
+class BitMatrix
+{
+public:
+  using block_type  = Block;
+  using size_type   = size_t;
+  using buffer_type = std::vector<Block,CacheAlignedAllocator<Block>>;
+
+  static constexpr const size_t bits_per_block  = std::numeric_limits<Block>::digits;
+  static constexpr const size_t blocks_per_line = cache_line_size / sizeof(Block);
+
+private:
+  size_t       m_num_rows;
+  size_t       m_num_bits;
+  size_t       m_num_blocks;
+  size_t       m_stride;
+  buffer_type  m_bits;
+
+  static size_type block_index(size_type pos) noexcept { return pos / bits_per_block; }
+  static Block     bit_mask   (size_type pos) noexcept { return Block(1) << (pos % bits_per_block); }
+
+public:
+
+  BitMatrix(size_t num_rows, size_t num_bits) :
+      m_num_rows(num_rows),
+      m_num_bits(num_bits),
+      m_num_blocks((num_bits-1) / bits_per_block + 1),
+      m_stride((m_num_blocks + blocks_per_line - 1) / blocks_per_line * blocks_per_line),
+      m_bits(m_num_rows * m_stride)
+  {  }
+
+  BitMatrix() = delete;
+  BitMatrix(BitMatrix const &) = default;
+  BitMatrix(BitMatrix &&) noexcept = default;
+
+  BitMatrix &operator=(BitMatrix const &) = default;
+  BitMatrix &operator=(BitMatrix &&) noexcept = default;
+
+  ~BitMatrix() = default;
+
+  [[nodiscard]] size_t num_rows() const noexcept
+  {
+    return m_num_rows;
+  }
+
+  // the number of bits of each row
+  [[nodiscard]] size_t size() const noexcept
+  {
+    return m_num_bits;
+  }
+
+  // the number of used blocks of each row
+  [[nodiscard]] size_t num_blocks() const noexcept
+  {
+    return m_num_blocks;
+  }
+
+  // the distance in blocks between two consecutive rows
+  [[nodiscard]] size_t stride() const noexcept
+  {
+    return m_stride;
+  }
+
+  [[nodiscard]] block_type *row(size_t r) noexcept
+  {
+    assert(r < m_num_rows);
+
+    return m_bits.data() + r * m_stride;
+  }
+
+  [[nodiscard]] block_type const *row(size_t r) const noexcept
+  {
+    assert(r < m_num_rows);
+
+    return m_bits.data() + r * m_stride;
+  }
+
+  [[nodiscard]] block_type const *data() const noexcept
+  {
+    return m_bits.data();
+  }
+
+  BitMatrix &set(size_t r, size_t pos)
+  {
+    assert(pos < m_num_bits);
+
+    row(r)[block_index(pos)] |= bit_mask(pos);
+
+    return *this;
+  }
+
+  BitMatrix &clear(size_t r, size_t pos)
+  {
+    assert(pos < m_num_bits);
+
+    row(r)[block_index(pos)] &= ~bit_mask(pos);
+
+    return *this;
+  }
+
+  [[nodiscard]] block_type at(size_t r, size_t pos) const noexcept
+  {
+    assert(pos < m_num_bits);
+
+    return row(r)[block_index(pos)] >> (pos % bits_per_block) & static_cast<block_type>(1);
+  }
+
+  void reset() noexcept
+  {
+    std::fill(m_bits.begin(), m_bits.end(), Block(0));
+  }
+
+  // copy a bit array (BitArray, StaticBitArray) into row r
+  template <typename Bits>
+  void assign_row(size_t r, Bits const &bits)
+  {
+    assert(bits.size() == m_num_bits);
+
+    std::copy(bits.data(), bits.data() + m_num_blocks, row(r));
+  }
+
+  // the (right) rotates of one source train by every shift, row k is the
+  //  source rotated by shifts[k]; all the rows are written in a single pass
+  //  over the source and the matrix must have shifts.size() rows
+  template <typename Bits>
+  void rotate_batch(Bits const &src, std::span<size_t const> shifts,
+                    kernels::simd_level level = kernels::cpu_simd_level())
+  {
+    assert(src.size() == m_num_bits);
+    assert(shifts.size() == m_num_rows);
+
+    kernels::rotate_batch(kernels::clamp_simd_level(level), m_bits.data(), m_stride, src.data(),
+                          m_num_bits, shifts.data(), shifts.size());
+  }
+};
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_BITMATRIX_HPP
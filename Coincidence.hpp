@@ -0,0 +1,198 @@
+/**
+ * @file Coincidence.hpp
+ *
+ * @brief Fused coincidence counters of two spike trains
+ *
+ * @ingroup neurolingo
+ *
+ * The core query of the clustering coefficient is "build the left (right)
+ * neighbour mask of B with window dt, AND it with A and count the ones".
+ * The counters below stream A and produce the mask of B one block at a time
+ * in a register (see MaskKernels.hpp), so there is no temporary mask and no
+ * allocation. They work on any bit array with 'data()' and 'size()', i.e.,
+ * BitArray and StaticBitArray.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_COINCIDENCE_HPP
+#define BITARRAYFASTROTATE_COINCIDENCE_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include <type_traits>
+#include <bit>
+
+#include "MaskKernels.hpp"
+
+namespace nlg {
+
+// common(a, mask) of the mask which 'kernel' emits to its callback, the
+//  blocks are counted a chunk at a time with the vectorized popcount_and
+template <typename Bits, typename Kernel>
+[[nodiscard]] size_t count_common_with_mask(Bits const &a, Kernel &&kernel)
+{
+  using block_type = std::remove_cv_t<std::remove_reference_t<decltype(*a.data())>>;
+
+  kernels::and_counter<block_type> counter(a.data(), (a.size() - 1) / kernels::bits_of<block_type> + 1);
+
+  kernel(counter);
+  counter.flush();
+
+  return counter.count();
+}
+
+// the number of spikes of a which follow a spike of b by at most dt bins,
+//  i.e., common(a, left neighbour mask of b)
+template <typename Bits>
+[[nodiscard]] size_t count_left_coincidences(Bits const &a, Bits const &b, size_t dt)
+{
+  assert(a.size() == b.size());
+
+  return count_common_with_mask(a, [&](auto &emit) { kernels::dilate_left(b.data(), b.size(), dt, emit); });
+}
+
+// the number of spikes of a which precede a spike of b by at most dt bins,
+//  i.e., common(a, right neighbour mask of b)
+template <typename Bits>
+[[nodiscard]] size_t count_right_coincidences(Bits const &a, Bits const &b, size_t dt)
+{
+  assert(a.size() == b.size());
+
+  return count_common_with_mask(a, [&](auto &emit) { kernels::dilate_right(b.data(), b.size(), dt, emit); });
+}
+
+// the number of spikes of a which follow a spike of b by dt_min to dt_max
+//  bins, i.e., common(a, left lag mask of b); a dt_min above 0 excludes
+//  the exact synchrony
+template <typename Bits>
+[[nodiscard]] size_t count_left_lag_coincidences(Bits const &a, Bits const &b, size_t dt_min, size_t dt_max)
+{
+  assert(a.size() == b.size());
+
+  return count_common_with_mask(a, [&](auto &emit) { kernels::dilate_left_lag(b.data(), b.size(), dt_min, dt_max, emit); });
+}
+
+// the number of spikes of a which precede a spike of b by dt_min to dt_max bins
+template <typename Bits>
+[[nodiscard]] size_t count_right_lag_coincidences(Bits const &a, Bits const &b, size_t dt_min, size_t dt_max)
+{
+  assert(a.size() == b.size());
+
+  return count_common_with_mask(a, [&](auto &emit) { kernels::dilate_right_lag(b.data(), b.size(), dt_min, dt_max, emit); });
+}
+
+// the circular counters, the windows wrap around the ends of the trains
+//  as in the rotate surrogates, i.e., common(a, circular mask of b)
+template <typename Bits>
+[[nodiscard]] size_t count_circular_left_coincidences(Bits const &a, Bits const &b, size_t dt)
+{
+  assert(a.size() == b.size());
+
+  return count_common_with_mask(a, [&](auto &emit) { kernels::dilate_left_circular(b.data(), b.size(), dt, emit); });
+}
+
+template <typename Bits>
+[[nodiscard]] size_t count_circular_right_coincidences(Bits const &a, Bits const &b, size_t dt)
+{
+  assert(a.size() == b.size());
+
+  return count_common_with_mask(a, [&](auto &emit) { kernels::dilate_right_circular(b.data(), b.size(), dt, emit); });
+}
+
+enum class window_side
+{
+  left,         // b precedes a, the left neighbour mask
+  right,        // b follows a, the right neighbour mask
+  symmetric     // either, the union of the two masks
+};
+
+// the coincidence counts for every window dt in [0, dt_max] in one pass,
+//  counts[dt] = common(a, mask of b with window dt); each spike of a
+//  votes once for the distance to its nearest spike of b on the side(s)
+//  of the window and the counts are the prefix sums of the votes
+template <typename Bits>
+[[nodiscard]] std::vector<size_t> sweep_coincidences(Bits const &a, Bits const &b, size_t dt_max,
+                                                     window_side side = window_side::left)
+{
+  assert(a.size() == b.size());
+
+  using block_type = std::remove_cv_t<std::remove_reference_t<decltype(*a.data())>>;
+
+  constexpr size_t bpb  = kernels::bits_of<block_type>;
+  constexpr size_t none = ~size_t(0);
+
+  auto const  *abits      = a.data();
+  auto const  *bbits      = b.data();
+  size_t const num_blocks = (a.size() - 1) / bpb + 1;
+
+  std::vector<size_t> counts(dt_max + 2, 0);    // the last one collects the distances above dt_max
+
+  size_t prev_b      = none;    // the last spike of b before the current block
+  size_t next_block  = 0;       // the first block after the current one with a spike of b,
+  size_t next_b      = none;    //  and its first spike
+
+  for (size_t i = 0; i < num_blocks; i++)
+  {
+    block_type const x    = abits[i];
+    block_type const y    = bbits[i];
+    size_t const     base = i * bpb;
+
+    if (x != 0)
+    {
+      if (next_block <= i)
+      {
+        for (next_block = i + 1; (next_block < num_blocks) && (bbits[next_block] == 0); next_block++)
+          ;
+
+        next_b = (next_block < num_blocks) ? next_block * bpb + std::countr_zero(bbits[next_block]) : none;
+      }
+
+      for (block_type spikes = x; spikes != 0; spikes &= spikes - 1)
+      {
+        size_t const bit = std::countr_zero(spikes);
+        size_t const t   = base + bit;
+        size_t       d   = none;
+
+        if (side != window_side::right)
+        {
+          auto const before = static_cast<block_type>(y & (kernels::low_mask<block_type>(bit) | (block_type(1) << bit)));
+          size_t const prev = (before != 0) ? base + bpb - 1 - std::countl_zero(before) : prev_b;
+
+          if (prev != none)
+            d = t - prev;
+        }
+
+        if (side != window_side::left)
+        {
+          auto const after = static_cast<block_type>(y >> bit);
+          size_t const next = (after != 0) ? t + std::countr_zero(after) : next_b;
+
+          if (next != none)
+            d = std::min(d, next - t);
+        }
+
+        counts[std::min(d, dt_max + 1)]++;
+      }
+    }
+
+    if (y != 0)
+      prev_b = base + bpb - 1 - std::countl_zero(y);
+  }
+
+  counts.pop_back();
+
+  for (size_t dt = 1; dt <= dt_max; dt++)
+    counts[dt] += counts[dt - 1];
+
+  return counts;
+}
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_COINCIDENCE_HPP
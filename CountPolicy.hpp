@@ -0,0 +1,162 @@
+/**
+ * @file CountPolicy.hpp
+ *
+ * @brief Policies for the count of set bits of BitArray and StaticBitArray
+ *
+ * @ingroup neurolingo
+ *
+ * The bit arrays take the policy as a template parameter and route every
+ * write through it:
+ *
+ *   count_none   no count is kept, set/clear and the bulk writers pay
+ *                nothing and count() counts the bits on every call
+ *   count_eager  the exact count is kept, set/clear test the bit before
+ *                they write it and the masks count the blocks they store,
+ *                count() is O(1)
+ *   count_lazy   the writes only mark the count dirty and count() counts
+ *                the bits on its first call after them
+ *
+ * A policy is also the storage of the count, so copying it with the bits
+ * copies the count, e.g., a rotate keeps the count of its operand.
+ * Writes through the non const block iterators are not seen by any policy;
+ * 'recount()' resynchronizes the count after them.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_COUNTPOLICY_HPP
+#define BITARRAYFASTROTATE_COUNTPOLICY_HPP
+
+#include <cstddef>
+
+#include "BitKernels.hpp"
+
+namespace nlg {
+
+struct count_none
+{
+  // the bulk writers, e.g., the masks, count the blocks they store
+  static constexpr bool counts_bulk = false;
+
+  template <typename Block>
+  void set(Block &block, Block mask) noexcept
+  {
+    block |= mask;
+  }
+
+  template <typename Block>
+  void clear(Block &block, Block mask) noexcept
+  {
+    block &= ~mask;
+  }
+
+  // the bits were written in bulk and have 'count' ones
+  void assign(std::size_t) noexcept
+  {  }
+
+  // the bits were written in bulk and their count is unknown
+  template <typename Block>
+  void invalidate(Block const *, std::size_t) noexcept
+  {  }
+
+  template <typename Block>
+  [[nodiscard]] std::size_t count(Block const *bits, std::size_t num_blocks) const noexcept
+  {
+    return kernels::popcount(bits, num_blocks);
+  }
+};
+
+class count_eager
+{
+  std::size_t m_count{0};
+
+public:
+  static constexpr bool counts_bulk = true;
+
+  template <typename Block>
+  void set(Block &block, Block mask) noexcept
+  {
+    m_count += (block & mask) == 0;
+    block   |= mask;
+  }
+
+  template <typename Block>
+  void clear(Block &block, Block mask) noexcept
+  {
+    m_count -= (block & mask) != 0;
+    block   &= ~mask;
+  }
+
+  void assign(std::size_t count) noexcept
+  {
+    m_count = count;
+  }
+
+  template <typename Block>
+  void invalidate(Block const *bits, std::size_t num_blocks) noexcept
+  {
+    m_count = kernels::popcount(bits, num_blocks);
+  }
+
+  template <typename Block>
+  [[nodiscard]] std::size_t count(Block const *, std::size_t) const noexcept
+  {
+    return m_count;
+  }
+};
+
+// the cached count is updated inside the const count(), so the count() of
+//  one array must not be called from two threads at the same time
+class count_lazy
+{
+  mutable std::size_t m_count{0};
+  mutable bool        m_valid{true};
+
+public:
+  static constexpr bool counts_bulk = false;
+
+  template <typename Block>
+  void set(Block &block, Block mask) noexcept
+  {
+    block   |= mask;
+    m_valid  = false;
+  }
+
+  template <typename Block>
+  void clear(Block &block, Block mask) noexcept
+  {
+    block   &= ~mask;
+    m_valid  = false;
+  }
+
+  void assign(std::size_t count) noexcept
+  {
+    m_count = count;
+    m_valid = true;
+  }
+
+  template <typename Block>
+  void invalidate(Block const *, std::size_t) noexcept
+  {
+    m_valid = false;
+  }
+
+  template <typename Block>
+  [[nodiscard]] std::size_t count(Block const *bits, std::size_t num_blocks) const noexcept
+  {
+    if (!m_valid)
+    {
+      m_count = kernels::popcount(bits, num_blocks);
+      m_valid = true;
+    }
+
+    return m_count;
+  }
+};
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_COUNTPOLICY_HPP
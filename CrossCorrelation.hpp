@@ -0,0 +1,221 @@
+/**
+ * @file CrossCorrelation.hpp
+ *
+ * @brief The circular coincidence profile of two spike trains for all shifts
+ *
+ * @ingroup neurolingo
+ *
+ * For two bit arrays A and B of N bits the profile is the vector
+ * profile[s] = common(A, rotate(B, s)) for every shift s in [0, N),
+ * i.e., the circular cross-correlation of the two trains. It is the null
+ * distribution of the coincidences under the rotate surrogate. Three
+ * engines compute it:
+ *
+ *  - direct : the fused 'common_rotated' for every shift, O(N * N/64)
+ *  - sparse : every pair of spikes (i in A, j in B) votes for the shift
+ *             (i - j) mod N, O(|A| * |B|)
+ *  - fft    : the correlation theorem over a zero padded power of two
+ *             length, O(N log N)
+ *
+ * and 'automatic' picks the cheapest one from the sizes and the spike counts.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_CROSSCORRELATION_HPP
+#define BITARRAYFASTROTATE_CROSSCORRELATION_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <vector>
+#include <bit>
+
+#include "BitArray.hpp"
+
+namespace nlg {
+
+enum class profile_method
+{
+  automatic,
+  direct,
+  sparse,
+  fft
+};
+
+struct CoincidenceProfile
+{
+  std::vector<size_t> counts;    // counts[s] = common(a, rotate(b, s))
+  size_t              zero_lag;  // common(a, b) as computed by common(), equal to counts[0]
+  profile_method      method;    // the engine which computed the counts
+};
+
+namespace detail {
+
+  // iterative radix-2 complex FFT, the size must be a power of two
+  inline void fft(std::vector<std::complex<double>> &data, bool inverse)
+  {
+    size_t const n = data.size();
+
+    assert(std::has_single_bit(n));
+
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+      size_t bit = n >> 1;
+
+      for (; j & bit; bit >>= 1)
+        j ^= bit;
+      j ^= bit;
+
+      if (i < j)
+        std::swap(data[i], data[j]);
+    }
+
+    // the twiddles are computed directly, not by repeated multiplication,
+    //  to keep the rounding error low for the long transforms
+    std::vector<std::complex<double>> roots(n / 2);
+
+    for (size_t k = 0; k < n / 2; k++)
+    {
+      double const angle = (inverse ? 2.0 : -2.0) * std::numbers::pi * double(k) / double(n);
+
+      roots[k] = std::complex<double>(std::cos(angle), std::sin(angle));
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+      size_t const stride = n / len;
+
+      for (size_t i = 0; i < n; i += len)
+      {
+        for (size_t j = 0; j < len / 2; j++)
+        {
+          std::complex<double> const u = data[i + j];
+          std::complex<double> const v = data[i + j + len / 2] * roots[j * stride];
+
+          data[i + j]           = u + v;
+          data[i + j + len / 2] = u - v;
+        }
+      }
+    }
+
+    if (inverse)
+      for (auto &x : data)
+        x /= double(n);
+  }
+
+  template <typename Block, typename Allocator, typename CountPolicy>
+  std::vector<uint32_t> set_positions(BitArray<Block,Allocator,CountPolicy> const &bits)
+  {
+    std::vector<uint32_t> positions;
+
+    for (size_t i = 0; i < bits.num_blocks(); i++)
+      for (Block block = bits.data()[i]; block != 0; block &= block - 1)
+        positions.push_back(static_cast<uint32_t>(i * BitArray<Block,Allocator,CountPolicy>::bits_per_block + std::countr_zero(block)));
+
+    return positions;
+  }
+
+  template <typename Block, typename Allocator, typename CountPolicy>
+  void profile_direct(BitArray<Block,Allocator,CountPolicy> const &a, BitArray<Block,Allocator,CountPolicy> const &b, std::vector<size_t> &counts)
+  {
+    for (size_t s = 0; s < a.size(); s++)
+      counts[s] = a.common_rotated(b, s);
+  }
+
+  template <typename Block, typename Allocator, typename CountPolicy>
+  void profile_sparse(BitArray<Block,Allocator,CountPolicy> const &a, BitArray<Block,Allocator,CountPolicy> const &b, std::vector<size_t> &counts)
+  {
+    size_t const          num_bits = a.size();
+    std::vector<uint32_t> const bpos = set_positions(b);
+
+    for (uint32_t i : set_positions(a))
+      for (uint32_t j : bpos)
+        counts[i >= j ? i - j : i + num_bits - j]++;
+  }
+
+  // both trains are packed in one complex transform, a in the real and b in
+  //  the imaginary part, and the circular correlation is folded out of the
+  //  linear one: counts[s] = r[s] + r[s - N]
+  template <typename Block, typename Allocator, typename CountPolicy>
+  void profile_fft(BitArray<Block,Allocator,CountPolicy> const &a, BitArray<Block,Allocator,CountPolicy> const &b, std::vector<size_t> &counts)
+  {
+    size_t const num_bits = a.size();
+    size_t const len      = std::bit_ceil(2 * num_bits);
+
+    std::vector<std::complex<double>> z(len);
+
+    for (size_t i = 0; i < num_bits; i++)
+      z[i] = std::complex<double>(double(a.at(i)), double(b.at(i)));
+
+    fft(z, false);
+
+    std::vector<std::complex<double>> p(len);
+
+    for (size_t k = 0; k < len; k++)
+    {
+      std::complex<double> const zk  = z[k];
+      std::complex<double> const zmk = std::conj(z[(len - k) & (len - 1)]);
+      std::complex<double> const fa  = (zk + zmk) * 0.5;
+      std::complex<double> const fb  = (zk - zmk) * std::complex<double>(0.0, -0.5);
+
+      p[k] = fa * std::conj(fb);
+    }
+
+    fft(p, true);
+
+    counts[0] = static_cast<size_t>(std::llround(p[0].real()));
+    for (size_t s = 1; s < num_bits; s++)
+      counts[s] = static_cast<size_t>(std::llround(p[s].real() + p[len - num_bits + s].real()));
+  }
+
+  inline profile_method choose_profile_method(size_t num_bits, size_t num_blocks, size_t ones_a, size_t ones_b)
+  {
+    // rough operation counts of the three engines
+    double const direct = double(num_bits) * double(num_blocks);
+    double const sparse = double(ones_a) * double(ones_b) + double(num_bits);
+    double const len    = double(std::bit_ceil(2 * num_bits));
+    double const fft    = 12.0 * len * std::log2(len);
+
+    if ( (sparse <= direct) && (sparse <= fft) )
+      return profile_method::sparse;
+
+    return (direct <= fft) ? profile_method::direct : profile_method::fft;
+  }
+
+}  // namespace detail
+
+// the circular coincidence profile of a and b,
+//  counts[s] = common(a, rotate(b, s)) for s in [0, a.size())
+template <typename Block, typename Allocator, typename CountPolicy>
+CoincidenceProfile circular_coincidence_profile(BitArray<Block,Allocator,CountPolicy> const &a,
+                                                BitArray<Block,Allocator,CountPolicy> const &b,
+                                                profile_method method = profile_method::automatic)
+{
+  assert(a.size() == b.size());
+
+  CoincidenceProfile profile{std::vector<size_t>(a.size(), 0), a.common(b), method};
+
+  if (method == profile_method::automatic)
+    profile.method = detail::choose_profile_method(a.size(), a.num_blocks(),
+                                                   kernels::popcount(a.data(), a.num_blocks()),
+                                                   kernels::popcount(b.data(), b.num_blocks()));
+
+  switch (profile.method)
+  {
+    case profile_method::sparse: detail::profile_sparse(a, b, profile.counts); break;
+    case profile_method::fft:    detail::profile_fft(a, b, profile.counts);    break;
+    default:                     detail::profile_direct(a, b, profile.counts); break;
+  }
+
+  return profile;
+}
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_CROSSCORRELATION_HPP
@@ -0,0 +1,203 @@
+/**
+ * @file Gram.hpp
+ *
+ * @brief The all pairs coincidence (Gram) matrix of a population
+ *
+ * @ingroup neurolingo
+ *
+ * gram[i * N + j] = common(train i, train j), a boolean matrix product with
+ * popcount in place of the sum. The kernel is blocked three ways:
+ *
+ *  - the blocks are cut in chunks of gram_chunk_blocks, so the two tiles
+ *    which meet stay in L2 for the whole chunk
+ *  - the rows are cut in tiles of gram_tile_rows, the pairs of tiles
+ *    (I <= J) are split statically over the threads
+ *  - inside a pair of tiles the micro kernel counts 4 x 4 pairs at a time
+ *    with the sums in registers (see kernels::popcount_and_4x4); without
+ *    AVX-512 VPOPCNTDQ the pairs are counted one by one with popcount_and
+ *
+ * Only the upper triangle, the diagonal included, is written; the lower
+ * one is left as it is.
+ *
+ * The diagonal holds |A_i|, so every pair measure (Jaccard, Hamming,
+ * cosine) follows from the Gram matrix without reading the trains again.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_GRAM_HPP
+#define BITARRAYFASTROTATE_GRAM_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <span>
+#include <type_traits>
+
+#include "BitKernels.hpp"
+#include "Population.hpp"
+#include "Parallel.hpp"
+
+namespace nlg {
+
+inline constexpr size_t gram_tile_rows    = 32;
+inline constexpr size_t gram_chunk_blocks = 512;
+
+// gram[i * num_rows + j] = popcount(row(i) & row(j)) for i <= j, the rows
+//  have num_blocks blocks
+template <typename Block, typename Rows>
+void count_all_pairs(Rows const &row, size_t num_rows, size_t num_blocks, std::span<size_t> gram,
+                     unsigned num_threads = 0)
+{
+  assert(gram.size() == num_rows * num_rows);
+
+  kernels::simd_level const level     = kernels::cpu_simd_level();
+  bool const                blocked   = kernels::has_blocked_popcount_and_4x4<Block>(level);
+  size_t const              num_tiles = (num_rows + gram_tile_rows - 1) / gram_tile_rows;
+  size_t const              num_pairs = num_tiles * (num_tiles + 1) / 2;
+
+  parallel_for_static(num_pairs, num_threads, [&](size_t beg, size_t end)
+  {
+    size_t tile_i = 0;      // the pair of tiles of index beg, the pairs are
+    size_t tile_j = beg;    //  numbered row by row over the upper triangle
+
+    while (tile_j >= num_tiles - tile_i)
+    {
+      tile_j -= num_tiles - tile_i;
+      tile_i++;
+    }
+
+    tile_j += tile_i;
+
+    size_t acc[gram_tile_rows][gram_tile_rows];
+
+    for (size_t p = beg; p < end; p++)
+    {
+      size_t const i0 = tile_i * gram_tile_rows, i1 = std::min(i0 + gram_tile_rows, num_rows);
+      size_t const j0 = tile_j * gram_tile_rows, j1 = std::min(j0 + gram_tile_rows, num_rows);
+
+      std::fill(&acc[0][0], &acc[0][0] + gram_tile_rows * gram_tile_rows, size_t{0});
+
+      for (size_t first = 0; first < num_blocks; first += gram_chunk_blocks)
+      {
+        size_t const count = std::min(gram_chunk_blocks, num_blocks - first);
+
+        for (size_t i = i0; i < i1; i += 4)
+        {
+          Block const *a[4];
+
+          // the rows past the end repeat the last one and their sums are dropped
+          for (size_t r = 0; r < 4; r++)
+            a[r] = row(std::min(i + r, i1 - 1)) + first;
+
+          for (size_t j = (tile_i == tile_j) ? i : j0; j < j1; j += 4)
+          {
+            Block const *b[4];
+            size_t       sums[16] = {};
+
+            for (size_t c = 0; c < 4; c++)
+              b[c] = row(std::min(j + c, j1 - 1)) + first;
+
+            // without the blocked micro kernel the pairs are counted one by
+            //  one in the same order, which keeps the 8 rows in L1, and the
+            //  pairs which are dropped are not counted at all
+            if (!blocked)
+            {
+              for (size_t r = 0; (r < 4) && (i + r < i1); r++)
+                for (size_t c = 0; (c < 4) && (j + c < j1); c++)
+                  if (i + r <= j + c)
+                    acc[i + r - i0][j + c - j0] += kernels::popcount_and(level, a[r], b[c], count);
+
+              continue;
+            }
+
+            kernels::popcount_and_4x4(level, a, b, count, sums);
+
+            for (size_t r = 0; (r < 4) && (i + r < i1); r++)
+              for (size_t c = 0; (c < 4) && (j + c < j1); c++)
+                acc[i + r - i0][j + c - j0] += sums[4 * r + c];
+          }
+        }
+      }
+
+      for (size_t i = i0; i < i1; i++)
+        for (size_t j = std::max(i, j0); j < j1; j++)
+          gram[i * num_rows + j] = acc[i - i0][j - j0];
+
+      if (++tile_j == num_tiles)
+      {
+        tile_i++;
+        tile_j = tile_i;
+      }
+    }
+  });
+}
+
+// the Gram matrix of a population (a vector of BitArray or a BitMatrix),
+//  gram has N x N elements and only its upper triangle is written
+template <typename Population>
+void gram_matrix(Population const &trains, std::span<size_t> gram, unsigned num_threads = 0)
+{
+  auto const rows = population_rows(trains);
+
+  using block_type = std::remove_cv_t<std::remove_pointer_t<decltype(rows(0))>>;
+
+  count_all_pairs<block_type>(rows, population_size(trains), population_num_blocks(trains), gram, num_threads);
+}
+
+// the pair measures of similarity_matrix, see kernels::pair_stats
+enum class similarity
+{
+  jaccard,
+  hamming,
+  cosine
+};
+
+inline double similarity_of(kernels::pair_stats const &stats, similarity measure) noexcept
+{
+  switch (measure)
+  {
+    case similarity::jaccard: return stats.jaccard();
+    case similarity::hamming: return stats.hamming();
+    case similarity::cosine:  return stats.cosine();
+  }
+
+  return 0.0;
+}
+
+// the similarity matrix of a population from its Gram matrix, which is
+//  written to gram (see gram_matrix), out[i * N + j] = measure(i, j); out
+//  is symmetric and written whole, its diagonal included
+template <typename Population>
+void similarity_matrix(Population const &trains, similarity measure, std::span<size_t> gram, std::span<double> out,
+                       unsigned num_threads = 0)
+{
+  size_t const num_rows = population_size(trains);
+
+  assert(out.size() == num_rows * num_rows);
+
+  gram_matrix(trains, gram, num_threads);
+
+  parallel_for_static(num_rows, num_threads, [&](size_t beg, size_t end)
+  {
+    for (size_t i = beg; i < end; i++)
+      for (size_t j = i; j < num_rows; j++)
+      {
+        kernels::pair_stats stats;
+
+        stats.ones_a = gram[i * num_rows + i];
+        stats.ones_b = gram[j * num_rows + j];
+        stats.common = gram[i * num_rows + j];
+        stats.differ = stats.ones_a + stats.ones_b - 2 * stats.common;
+
+        out[i * num_rows + j] = out[j * num_rows + i] = similarity_of(stats, measure);
+      }
+  });
+}
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_GRAM_HPP
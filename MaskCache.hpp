@@ -0,0 +1,148 @@
+/**
+ * @file MaskCache.hpp
+ *
+ * @brief Cache of the neighbour masks of every train of a population
+ *
+ * @ingroup neurolingo
+ *
+ * In the clustering coefficient every neuron meets N-1 partners with the
+ * same few windows dt, so its masks are built once and kept here instead of
+ * once per partner. The entries are keyed by (train, kind, dt), where the
+ * train is its index in the population and dt one of the windows given at
+ * construction. All the masks live in one BitMatrix, one row per entry.
+ *
+ * An entry is built on its first use and rebuilt when the generation of
+ * its train has changed since, i.e., after a set, clear, rotate, etc.
+ * The population must outlive the cache and keep its size.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_MASKCACHE_HPP
+#define BITARRAYFASTROTATE_MASKCACHE_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <span>
+#include <vector>
+#include <bit>
+
+#include "BitArray.hpp"
+#include "BitMatrix.hpp"
+#include "MaskKernels.hpp"
+
+namespace nlg {
+
+enum class mask_kind
+{
+  left,
+  right,
+  circular_left,
+  circular_right
+};
+
+template <typename Block=std::uint64_t, typename Allocator=std::allocator<Block>, typename CountPolicy=count_eager>
+class MaskCache
+{
+public:
+  using bits_type = BitArray<Block,Allocator,CountPolicy>;
+
+  static constexpr const size_t num_kinds = 4;
+
+private:
+  std::vector<bits_type> const &m_trains;
+  std::vector<size_t>           m_dts;
+  BitMatrix<Block>              m_masks;
+  std::vector<uint64_t>         m_stamps;       // generation + 1 of the train at the build, 0 if not built
+  size_t                        m_num_builds{0};
+
+  size_t entry(size_t train, mask_kind kind, size_t dt) const
+  {
+    auto it = std::find(m_dts.begin(), m_dts.end(), dt);
+
+    assert(train < m_trains.size());
+    assert(it != m_dts.end());
+
+    return (train * num_kinds + size_t(kind)) * m_dts.size() + size_t(it - m_dts.begin());
+  }
+
+  void build(size_t r, bits_type const &train, mask_kind kind, size_t dt)
+  {
+    Block *const out  = m_masks.row(r);
+    auto         emit = [out](size_t i, Block block) { out[i] = block; };
+
+    switch (kind)
+    {
+      case mask_kind::left:           kernels::dilate_left(train.data(), train.size(), dt, emit);           break;
+      case mask_kind::right:          kernels::dilate_right(train.data(), train.size(), dt, emit);          break;
+      case mask_kind::circular_left:  kernels::dilate_left_circular(train.data(), train.size(), dt, emit);  break;
+      case mask_kind::circular_right: kernels::dilate_right_circular(train.data(), train.size(), dt, emit); break;
+    }
+
+    m_num_builds++;
+  }
+
+public:
+
+  // a cache for the masks of trains with the windows dts, the trains
+  //  must have the same size
+  MaskCache(std::vector<bits_type> const &trains, std::span<size_t const> dts) :
+      m_trains(trains),
+      m_dts(dts.begin(), dts.end()),
+      m_masks(trains.size() * num_kinds * dts.size(), trains.empty() ? 1 : trains.front().size()),
+      m_stamps(trains.size() * num_kinds * dts.size(), 0)
+  {  }
+
+  MaskCache() = delete;
+  MaskCache(MaskCache const &) = delete;
+
+  MaskCache &operator=(MaskCache const &) = delete;
+
+  ~MaskCache() = default;
+
+  // the blocks of the mask of train, valid until the next call
+  //  which rebuilds the same entry
+  [[nodiscard]] Block const *mask(size_t train, mask_kind kind, size_t dt)
+  {
+    size_t const     r     = entry(train, kind, dt);
+    bits_type const &bits  = m_trains[train];
+    uint64_t const   stamp = bits.generation() + 1;
+
+    assert(bits.size() == m_masks.size());
+
+    if (m_stamps[r] != stamp)
+    {
+      build(r, bits, kind, dt);
+      m_stamps[r] = stamp;
+    }
+
+    return m_masks.row(r);
+  }
+
+  // common(a, mask of train), e.g., the left coincidences of a with train
+  [[nodiscard]] size_t coincidences(bits_type const &a, size_t train, mask_kind kind, size_t dt)
+  {
+    assert(a.size() == m_masks.size());
+
+    return kernels::popcount_and(a.data(), this->mask(train, kind, dt), m_masks.num_blocks());
+  }
+
+  // the number of masks built so far
+  [[nodiscard]] size_t num_builds() const noexcept
+  {
+    return m_num_builds;
+  }
+
+  [[nodiscard]] std::span<size_t const> dts() const noexcept
+  {
+    return m_dts;
+  }
+};
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_MASKCACHE_HPP
@@ -0,0 +1,484 @@
+/**
+ * @file MaskKernels.hpp
+ *
+ * @brief Block kernels for the left and right neighbour masks
+ *
+ * @ingroup neurolingo
+ *
+ * The left neighbour mask of B with window dt sets, for every '1' bit of B
+ * at position t, the bits [t, t+dt], i.e., it dilates B towards the higher
+ * positions (later time bins); the right mask sets [t-dt, t]. The bits
+ * shifted past either end of the array are dropped, or wrap around to the
+ * other end for the circular masks, as rotate treats the train.
+ *
+ * The kernels produce the mask one block at a time in a single pass: the
+ * spikes of the block itself are spread inside the register by shift
+ * doubling (1, 2, 4, ... bins), and the spikes of the previous blocks are
+ * summarized by the position up to which they reach, so a window of any
+ * width, even many blocks wide, costs one pass. The blocks are handed
+ * to an 'emit(index, block)' callback, so the same kernel stores the mask or
+ * feeds a fused consumer without materializing it.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_MASKKERNELS_HPP
+#define BITARRAYFASTROTATE_MASKKERNELS_HPP
+
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <utility>
+#include <span>
+#include <bit>
+
+#include "BitKernels.hpp"
+
+namespace nlg::kernels {
+
+// spread every set bit of x over the dt higher positions of the block
+template <typename Block>
+constexpr Block spread_left(Block x, std::size_t dt) noexcept
+{
+  // a window of a whole block fills everything above the lowest spike
+  if (dt >= bits_of<Block> - 1)
+    return static_cast<Block>(x | (Block(0) - x));
+
+  std::size_t span = 1;    // x covers the shifts [0, span)
+
+  for (; 2 * span <= dt + 1; span *= 2)
+    x |= static_cast<Block>(x << span);
+
+  if (span < dt + 1)
+    x |= static_cast<Block>(x << (dt + 1 - span));
+
+  return x;
+}
+
+// spread every set bit of x over the dt lower positions of the block
+template <typename Block>
+constexpr Block spread_right(Block x, std::size_t dt) noexcept
+{
+  // and everything below the highest spike
+  if (dt >= bits_of<Block> - 1)
+    return (x == 0) ? Block(0) : static_cast<Block>(~Block(0) >> std::countl_zero(x));
+
+  std::size_t span = 1;
+
+  for (; 2 * span <= dt + 1; span *= 2)
+    x |= static_cast<Block>(x >> span);
+
+  if (span < dt + 1)
+    x |= static_cast<Block>(x >> (dt + 1 - span));
+
+  return x;
+}
+
+// the left neighbour mask of num_bits bits, one block at a time; 'load(i)'
+//  returns the i-th source block and the positions before 'reach' are
+//  covered by spikes outside the array
+template <typename Block, typename Load, typename Emit>
+inline void dilate_left_from(Load &&load, std::size_t num_bits, std::size_t dt, std::size_t reach, Emit &&emit)
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t const num_blocks = (num_bits - 1) / bpb + 1;
+
+  for (std::size_t i = 0; i < num_blocks; i++)
+  {
+    std::size_t const base  = i * bpb;
+    Block const       x     = load(i);
+    Block             block = spread_left(x, dt);
+
+    if (reach > base)
+      block |= (reach - base >= bpb) ? static_cast<Block>(~Block(0)) : low_mask<Block>(reach - base);
+
+    if (x != 0)
+      reach = std::max(reach, base + bpb - std::countl_zero(x) + dt);
+
+    if ( (i == num_blocks - 1) && (num_bits % bpb != 0) )
+      block &= low_mask<Block>(num_bits % bpb);
+
+    emit(i, block);
+  }
+}
+
+template <typename Block, typename Emit>
+inline void dilate_left(Block const *src, std::size_t num_bits, std::size_t dt, std::size_t reach, Emit &&emit)
+{
+  dilate_left_from<Block>([src](std::size_t i) { return src[i]; }, num_bits, dt, reach, std::forward<Emit>(emit));
+}
+
+template <typename Block, typename Emit>
+inline void dilate_left(Block const *src, std::size_t num_bits, std::size_t dt, Emit &&emit)
+{
+  dilate_left(src, num_bits, dt, 0, std::forward<Emit>(emit));
+}
+
+// the right neighbour mask of num_bits bits, one block at a time from the
+//  last block to the first; the positions from 'reach' on are covered by
+//  spikes outside the array
+template <typename Block, typename Load, typename Emit>
+inline void dilate_right_from(Load &&load, std::size_t num_bits, std::size_t dt, std::size_t reach, Emit &&emit)
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t const num_blocks = (num_bits - 1) / bpb + 1;
+
+  for (std::size_t i = num_blocks; i-- > 0; )
+  {
+    std::size_t const base  = i * bpb;
+    Block const       x     = load(i);
+    Block             block = spread_right(x, dt);
+
+    if (reach < base + bpb)
+      block |= static_cast<Block>(~low_mask<Block>(reach > base ? reach - base : 0));
+
+    if (x != 0)
+    {
+      std::size_t const first = base + std::countr_zero(x);
+
+      reach = std::min(reach, (first > dt) ? first - dt : 0);
+    }
+
+    if ( (i == num_blocks - 1) && (num_bits % bpb != 0) )
+      block &= low_mask<Block>(num_bits % bpb);
+
+    emit(i, block);
+  }
+}
+
+template <typename Block, typename Emit>
+inline void dilate_right(Block const *src, std::size_t num_bits, std::size_t dt, std::size_t reach, Emit &&emit)
+{
+  dilate_right_from<Block>([src](std::size_t i) { return src[i]; }, num_bits, dt, reach, std::forward<Emit>(emit));
+}
+
+template <typename Block, typename Emit>
+inline void dilate_right(Block const *src, std::size_t num_bits, std::size_t dt, Emit &&emit)
+{
+  dilate_right(src, num_bits, dt, ~std::size_t(0), std::forward<Emit>(emit));
+}
+
+// the circular masks, the windows of the spikes near one end of the train
+//  wrap around to the other end; the wrapped part is found from the last
+//  (first) spike only and enters the kernel as its initial reach
+
+template <typename Block, typename Emit>
+inline void dilate_left_circular(Block const *src, std::size_t num_bits, std::size_t dt, Emit &&emit)
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t reach = 0;
+
+  for (std::size_t i = (num_bits - 1) / bpb + 1; i-- > 0; )
+  {
+    if (src[i] != 0)
+    {
+      std::size_t const end = i * bpb + bpb - std::countl_zero(src[i]) + dt;    // past the window of the last spike
+
+      reach = (end > num_bits) ? std::min(end - num_bits, num_bits) : 0;
+      break;
+    }
+  }
+
+  dilate_left(src, num_bits, dt, reach, std::forward<Emit>(emit));
+}
+
+template <typename Block, typename Emit>
+inline void dilate_right_circular(Block const *src, std::size_t num_bits, std::size_t dt, Emit &&emit)
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t const num_blocks = (num_bits - 1) / bpb + 1;
+  std::size_t       reach      = ~std::size_t(0);
+
+  for (std::size_t i = 0; i < num_blocks; i++)
+  {
+    if (src[i] != 0)
+    {
+      std::size_t const first = i * bpb + std::countr_zero(src[i]);
+
+      if (first < dt)
+        reach = (dt - first >= num_bits) ? 0 : num_bits - (dt - first);
+      break;
+    }
+  }
+
+  dilate_right(src, num_bits, dt, reach, std::forward<Emit>(emit));
+}
+
+// the lag window masks, a spike at t sets [t+dt_min, t+dt_max] (left) or
+//  [t-dt_max, t-dt_min] (right); the source is read shifted by dt_min
+//  and dilated by dt_max-dt_min in the same pass
+
+// the i-th block of src shifted towards the higher positions by s bits
+template <typename Block>
+inline Block shifted_up_block(Block const *src, std::size_t s, std::size_t i) noexcept
+{
+  std::size_t const q = s / bits_of<Block>;
+  std::size_t const r = s % bits_of<Block>;
+
+  if (i < q)
+    return Block(0);
+
+  auto block = static_cast<Block>(src[i - q] << r);
+
+  if ( (r != 0) && (i > q) )
+    block |= static_cast<Block>(src[i - q - 1] >> (bits_of<Block> - r));
+
+  return block;
+}
+
+// the i-th block of src shifted towards the lower positions by s bits
+template <typename Block>
+inline Block shifted_down_block(Block const *src, std::size_t num_blocks, std::size_t s, std::size_t i) noexcept
+{
+  std::size_t const pos = i * bits_of<Block> + s;
+
+  return (pos / bits_of<Block> < num_blocks) ? fetch_bits(src, num_blocks, pos) : Block(0);
+}
+
+template <typename Block, typename Emit>
+inline void dilate_left_lag(Block const *src, std::size_t num_bits, std::size_t dt_min, std::size_t dt_max, Emit &&emit)
+{
+  assert(dt_min <= dt_max);
+
+  dilate_left_from<Block>([src, dt_min](std::size_t i) { return shifted_up_block(src, dt_min, i); },
+                          num_bits, dt_max - dt_min, 0, std::forward<Emit>(emit));
+}
+
+template <typename Block, typename Emit>
+inline void dilate_right_lag(Block const *src, std::size_t num_bits, std::size_t dt_min, std::size_t dt_max, Emit &&emit)
+{
+  assert(dt_min <= dt_max);
+
+  std::size_t const num_blocks = (num_bits - 1) / bits_of<Block> + 1;
+
+  dilate_right_from<Block>([src, num_blocks, dt_min](std::size_t i) { return shifted_down_block(src, num_blocks, dt_min, i); },
+                           num_bits, dt_max - dt_min, ~std::size_t(0), std::forward<Emit>(emit));
+}
+
+// the sparse masks, the output is cleared and the windows of the spikes are
+//  written as runs of ones; the overlapping windows are merged first, so
+//  the cost follows the number of spikes instead of the window
+
+// set the bits [lo, hi] of dst
+template <typename Block>
+inline void set_run(Block *dst, std::size_t lo, std::size_t hi) noexcept
+{
+  constexpr std::size_t bpb = bits_of<Block>;
+
+  std::size_t const first = lo / bpb;
+  std::size_t const last  = hi / bpb;
+  auto const        head  = static_cast<Block>(~low_mask<Block>(lo % bpb));
+  auto const        tail  = (hi % bpb == bpb - 1) ? static_cast<Block>(~Block(0)) : low_mask<Block>(hi % bpb + 1);
+
+  if (first == last)
+  {
+    dst[first] |= static_cast<Block>(head & tail);
+
+    return;
+  }
+
+  dst[first] |= head;
+  std::fill(dst + first + 1, dst + last, static_cast<Block>(~Block(0)));
+  dst[last] |= tail;
+}
+
+// merges the windows, given in increasing order of their begin, into runs
+template <typename Block>
+class run_writer
+{
+  static constexpr std::size_t none = ~std::size_t(0);
+
+  Block       *m_dst;
+  std::size_t  m_lo{none};    // the pending run [lo, hi]
+  std::size_t  m_hi{0};
+  std::size_t  m_count{0};
+
+public:
+
+  // clears the num_blocks blocks of dst
+  run_writer(Block *dst, std::size_t num_blocks) noexcept : m_dst(dst)
+  {
+    std::fill(dst, dst + num_blocks, Block(0));
+  }
+
+  void push(std::size_t begin, std::size_t end) noexcept
+  {
+    if ( (m_lo != none) && (begin <= m_hi + 1) )
+    {
+      m_hi = std::max(m_hi, end);
+
+      return;
+    }
+
+    flush();
+
+    m_lo = begin;
+    m_hi = end;
+  }
+
+  void flush() noexcept
+  {
+    if (m_lo != none)
+    {
+      set_run(m_dst, m_lo, m_hi);
+      m_count += m_hi - m_lo + 1;
+      m_lo     = none;
+    }
+  }
+
+  // the number of bits written, after the last flush
+  [[nodiscard]] std::size_t count() const noexcept
+  {
+    return m_count;
+  }
+};
+
+// the left (right) mask from the sorted spike positions of a train of
+//  num_bits bits into dst; returns the number of bits of the mask
+template <typename Block, typename Position>
+inline std::size_t sparse_mask(Block *dst, std::size_t num_bits, std::span<Position const> spikes, std::size_t dt, bool left) noexcept
+{
+  run_writer<Block> runs(dst, (num_bits - 1) / bits_of<Block> + 1);
+
+  for (std::size_t t : spikes)
+  {
+    assert(t < num_bits);
+
+    if (left)
+      runs.push(t, std::min(t + dt, num_bits - 1));
+    else
+      runs.push(t > dt ? t - dt : 0, t);
+  }
+
+  runs.flush();
+
+  return runs.count();
+}
+
+// the same from the bits of src, which must not alias dst; the blocks
+//  are probed eight at a time so the empty stretches are skipped quickly
+template <typename Block>
+inline std::size_t sparse_mask(Block *dst, Block const *src, std::size_t num_bits, std::size_t dt, bool left) noexcept
+{
+  constexpr std::size_t bpb   = bits_of<Block>;
+  constexpr std::size_t group = 8;
+
+  std::size_t const num_blocks = (num_bits - 1) / bpb + 1;
+  run_writer<Block> runs(dst, num_blocks);
+
+  for (std::size_t g = 0; g < num_blocks; g += group)
+  {
+    std::size_t const end = std::min(g + group, num_blocks);
+    Block             any = 0;
+
+    for (std::size_t i = g; i < end; i++)
+      any |= src[i];
+
+    if (any == 0)
+      continue;
+
+    for (std::size_t i = g; i < end; i++)
+    {
+      for (Block spikes = src[i]; spikes != 0; spikes &= spikes - 1)
+      {
+        std::size_t const t = i * bpb + std::countr_zero(spikes);
+
+        if (left)
+          runs.push(t, std::min(t + dt, num_bits - 1));
+        else
+          runs.push(t > dt ? t - dt : 0, t);
+      }
+    }
+  }
+
+  runs.flush();
+
+  return runs.count();
+}
+
+// whether the sparse masks are cheaper than the dilation, from the
+//  spikes of up to 'samples' evenly spaced blocks; the sparse mask costs
+//  about a run per spike and the dilation a spread per block
+template <typename Block>
+inline bool sparse_mask_pays(Block const *src, std::size_t num_blocks, std::size_t dt, std::size_t samples = 32) noexcept
+{
+  std::size_t const step   = std::max<std::size_t>(1, num_blocks / samples);
+  std::size_t       spikes = 0;
+  std::size_t       probed = 0;
+
+  for (std::size_t i = 0; i < num_blocks; i += step, probed++)
+    spikes += std::popcount(src[i]);
+
+  // the scan of the blocks alone costs about as much as the dilation, so
+  //  the runs pay only below about one spike per eight blocks (0.2%)
+  return 8 * spikes * (1 + dt / bits_of<Block>) < probed;
+}
+
+// an emit callback which counts popcount(a & mask) of the blocks of the
+//  mask, in either order of the kernels; the blocks are collected in a
+//  chunk which stays in L1 and each chunk is counted with the vectorized
+//  popcount_and, in place of one scalar popcount per emitted block
+template <typename Block>
+class and_counter
+{
+  static constexpr std::size_t none         = ~std::size_t(0);
+  static constexpr std::size_t chunk_blocks = 256;
+
+  Block const *m_a;
+  std::size_t  m_num_blocks;
+  simd_level   m_level;
+  std::size_t  m_chunk{none};    // the chunk of the blocks being collected
+  std::size_t  m_count{0};
+  Block        m_blocks[chunk_blocks];
+
+  // out of the loop of the kernel, so it keeps its state in registers
+  [[gnu::noinline]] void next_chunk(std::size_t chunk) noexcept
+  {
+    flush();
+    m_chunk = chunk;
+  }
+
+public:
+
+  and_counter(Block const *a, std::size_t num_blocks, simd_level level = cpu_simd_level()) noexcept :
+    m_a(a), m_num_blocks(num_blocks), m_level(level)
+  {
+  }
+
+  void operator()(std::size_t i, Block block) noexcept
+  {
+    if (i / chunk_blocks != m_chunk) [[unlikely]]
+      next_chunk(i / chunk_blocks);
+
+    m_blocks[i % chunk_blocks] = block;
+  }
+
+  // counts the chunk being collected, all of its blocks must have been emitted
+  void flush() noexcept
+  {
+    if (m_chunk != none)
+    {
+      std::size_t const first = m_chunk * chunk_blocks;
+
+      m_count += popcount_and(m_level, m_a + first, m_blocks, std::min(chunk_blocks, m_num_blocks - first));
+      m_chunk  = none;
+    }
+  }
+
+  // the number of common bits, after the last flush
+  [[nodiscard]] std::size_t count() const noexcept
+  {
+    return m_count;
+  }
+};
+
+}  // namespace nlg::kernels
+
+#endif //BITARRAYFASTROTATE_MASKKERNELS_HPP
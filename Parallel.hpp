@@ -0,0 +1,69 @@
+/**
+ * @file Parallel.hpp
+ *
+ * @brief Static partitioning of index ranges over worker threads
+ *
+ * @ingroup neurolingo
+ *
+ * The population kernels split their rows (or tiles) in equal contiguous
+ * chunks, one per thread. The cost of a row depends only on its size, so
+ * a static partition is balanced without any work stealing.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_PARALLEL_HPP
+#define BITARRAYFASTROTATE_PARALLEL_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace nlg {
+
+// the number of threads to use when the caller passes 0, queried once
+//  since hardware_concurrency() is a system call
+inline unsigned default_num_threads() noexcept
+{
+  static unsigned const num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  return num_threads;
+}
+
+// call fn(begin, end) for num_threads contiguous chunks of [0, count);
+//  the first chunk runs on the calling thread
+template <typename Function>
+void parallel_for_static(size_t count, unsigned num_threads, Function &&fn)
+{
+  if (num_threads == 0)
+    num_threads = default_num_threads();
+
+  num_threads = static_cast<unsigned>(std::min<size_t>(num_threads, count));
+
+  if (num_threads <= 1)
+  {
+    if (count > 0)
+      fn(size_t{0}, count);
+
+    return;
+  }
+
+  std::vector<std::jthread> workers;
+
+  workers.reserve(num_threads - 1);
+
+  auto chunk_begin = [&](unsigned t) { return count * t / num_threads; };
+
+  for (unsigned t = 1; t < num_threads; t++)
+    workers.emplace_back([&fn, beg = chunk_begin(t), end = chunk_begin(t + 1)]() { fn(beg, end); });
+
+  fn(chunk_begin(0), chunk_begin(1));
+}
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_PARALLEL_HPP
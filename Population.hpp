@@ -0,0 +1,275 @@
+/**
+ * @file Population.hpp
+ *
+ * @brief Operations on a whole population of spike trains
+ *
+ * @ingroup neurolingo
+ *
+ * A population is either a vector of BitArray of equal size, one per
+ * neuron, or a BitMatrix with one row per neuron (a raster). The row loops
+ * are split statically over the worker threads (see Parallel.hpp) and the
+ * outputs are preallocated by the caller, so there are no allocations in
+ * the surrogate rounds.
+ *
+ * The one vs many kernel counts the coincidences of one query train with
+ * every train of the population. The query goes through L1 in tiles, each
+ * made once by a generator (the query, its masked bits) and counted
+ * against all the rows, so other queries of the library reuse it by passing
+ * their own generator, e.g., the triplet counts of a pair (a, b) pass the
+ * tiles of a & b. A rotated query is made whole, once per shift, in the
+ * workspace of the calling thread and tiled as a plain query.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_POPULATION_HPP
+#define BITARRAYFASTROTATE_POPULATION_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <span>
+#include <vector>
+#include <type_traits>
+
+#include "BitArray.hpp"
+#include "BitMatrix.hpp"
+#include "Parallel.hpp"
+
+namespace nlg {
+
+// (right) rotate every train of the population by its own shift,
+//  out[i] = rotate(trains[i], shifts[i]); out must have the same sizes
+template <typename Block, typename Allocator, typename CountPolicy>
+void rotate_population(std::vector<BitArray<Block,Allocator,CountPolicy>> const &trains,
+                       std::span<size_t const>                                   shifts,
+                       std::vector<BitArray<Block,Allocator,CountPolicy>>       &out,
+                       unsigned                                                  num_threads = 0)
+{
+  assert(trains.size() == shifts.size());
+  assert(trains.size() == out.size());
+
+  parallel_for_static(trains.size(), num_threads, [&](size_t beg, size_t end)
+  {
+    for (size_t i = beg; i < end; i++)
+      out[i].rotate_simd(trains[i], shifts[i]);
+  });
+}
+
+// the same for a raster, row i of out is row i of trains rotated by shifts[i]
+template <typename Block>
+void rotate_population(BitMatrix<Block> const  &trains,
+                       std::span<size_t const>  shifts,
+                       BitMatrix<Block>        &out,
+                       unsigned                 num_threads = 0)
+{
+  assert(trains.num_rows() == shifts.size());
+  assert( (trains.num_rows() == out.num_rows()) && (trains.size() == out.size()) );
+
+  kernels::simd_level const level    = kernels::cpu_simd_level();
+  size_t const              num_bits = trains.size();
+
+  parallel_for_static(trains.num_rows(), num_threads, [&](size_t beg, size_t end)
+  {
+    for (size_t i = beg; i < end; i++)
+    {
+      size_t const n = shifts[i] % num_bits;
+
+      if (n == 0)
+        std::copy(trains.row(i), trains.row(i) + trains.num_blocks(), out.row(i));
+      else
+        kernels::rotate_blocks(level, out.row(i), trains.row(i), num_bits, n);
+    }
+  });
+}
+
+// the blocks of a query tile, 2048 blocks (16 KiB) stay in L1 next to the
+//  streamed rows
+inline constexpr size_t query_tile_blocks = 2048;
+
+// the tile generators of the one vs many kernel, tile(first, count, buffer)
+//  returns the blocks first .. first+count-1 of the query, either in place
+//  or made in the buffer of query_tile_blocks blocks
+
+// the query itself
+template <typename Block>
+struct plain_query
+{
+  Block const *bits;
+
+  Block const *operator()(size_t first, [[maybe_unused]] size_t count, [[maybe_unused]] Block *buffer) const noexcept
+  {
+    return bits + first;
+  }
+};
+
+// the query restricted to a mask, e.g., a neighbour mask or a trial window
+template <typename Block>
+struct masked_query
+{
+  Block const *bits;
+  Block const *mask;
+
+  Block const *operator()(size_t first, size_t count, Block *buffer) const noexcept
+  {
+    for (size_t k = 0; k < count; k++)
+      buffer[k] = static_cast<Block>(bits[first + k] & mask[first + k]);
+
+    return buffer;
+  }
+};
+
+// counts[j] = popcount(query & row(j)) for the num_rows rows of num_blocks
+//  blocks; the query is made one tile at a time and every tile is counted
+//  against all the rows of a thread before the next one, so it is read (or
+//  made) once per thread instead of once per row; the rows are split over
+//  the threads
+template <typename Block, typename Tile, typename Rows>
+void count_one_vs_many(Tile const &tile, size_t num_blocks, Rows const &row, size_t num_rows,
+                       std::span<size_t> counts, unsigned num_threads = 0)
+{
+  assert(counts.size() == num_rows);
+
+  kernels::simd_level const level = kernels::cpu_simd_level();
+
+  parallel_for_static(num_rows, num_threads, [&](size_t beg, size_t end)
+  {
+    alignas(64) Block buffer[query_tile_blocks];
+
+    std::fill(counts.begin() + beg, counts.begin() + end, size_t{0});
+
+    for (size_t first = 0; first < num_blocks; first += query_tile_blocks)
+    {
+      size_t const       count = std::min(query_tile_blocks, num_blocks - first);
+      Block const *const query = tile(first, count, buffer);
+
+      for (size_t j = beg; j < end; j++)
+        counts[j] += kernels::popcount_and(level, query, row(j) + first, count);
+    }
+  });
+}
+
+// the rows of a population for the one vs many kernel
+template <typename Block, typename Allocator, typename CountPolicy>
+auto population_rows(std::vector<BitArray<Block,Allocator,CountPolicy>> const &trains) noexcept
+{
+  return [&trains](size_t j) { return trains[j].data(); };
+}
+
+template <typename Block>
+auto population_rows(BitMatrix<Block> const &trains) noexcept
+{
+  return [&trains](size_t j) { return trains.row(j); };
+}
+
+template <typename Block, typename Allocator, typename CountPolicy>
+size_t population_size(std::vector<BitArray<Block,Allocator,CountPolicy>> const &trains) noexcept
+{
+  return trains.size();
+}
+
+template <typename Block>
+size_t population_size(BitMatrix<Block> const &trains) noexcept
+{
+  return trains.num_rows();
+}
+
+template <typename Block, typename Allocator, typename CountPolicy>
+size_t population_num_blocks(std::vector<BitArray<Block,Allocator,CountPolicy>> const &trains) noexcept
+{
+  return trains.empty() ? 0 : trains.front().num_blocks();
+}
+
+template <typename Block>
+size_t population_num_blocks(BitMatrix<Block> const &trains) noexcept
+{
+  return trains.num_blocks();
+}
+
+// counts[j] = common(query, trains[j]), the coincidences of one neuron with
+//  every neuron of the population
+template <typename Bits, typename Population>
+void count_common(Bits const &query, Population const &trains, std::span<size_t> counts, unsigned num_threads = 0)
+{
+  using block_type = std::remove_cv_t<std::remove_reference_t<decltype(*query.data())>>;
+
+  count_one_vs_many<block_type>(plain_query<block_type>{query.data()}, query.num_blocks(),
+                                population_rows(trains), population_size(trains), counts, num_threads);
+}
+
+// counts[j] = common(rotate(query, n), trains[j]), e.g., one surrogate of
+//  the query against the population
+template <typename Bits, typename Population>
+void count_common_rotated(Bits const &query, size_t n, Population const &trains, std::span<size_t> counts,
+                          unsigned num_threads = 0)
+{
+  using block_type = std::remove_cv_t<std::remove_reference_t<decltype(*query.data())>>;
+
+  n %= query.size();
+
+  if (n == 0)
+  {
+    count_common(query, trains, counts, num_threads);
+
+    return;
+  }
+
+  // the rotated query is made once, by the run copies of the rotate plan,
+  //  in the scratch buffer of the calling thread and the threads tile over
+  //  it as over a plain query
+  auto &rotated = Bits::workspace_type::local().scratch(query.num_blocks());
+
+  kernels::rotate_blocks(kernels::cpu_simd_level(), rotated.data(), query.data(), query.size(), n);
+
+  count_one_vs_many<block_type>(plain_query<block_type>{rotated.data()}, query.num_blocks(),
+                                population_rows(trains), population_size(trains), counts, num_threads);
+}
+
+// counts[j] = common(query & mask, trains[j]), the mask has the size of
+//  the query, e.g., its neighbour mask or a window of trials
+template <typename Bits, typename Population>
+void count_common_masked(Bits const &query, Bits const &mask, Population const &trains, std::span<size_t> counts,
+                         unsigned num_threads = 0)
+{
+  using block_type = std::remove_cv_t<std::remove_reference_t<decltype(*query.data())>>;
+
+  assert(query.size() == mask.size());
+
+  count_one_vs_many<block_type>(masked_query<block_type>{query.data(), mask.data()}, query.num_blocks(),
+                                population_rows(trains), population_size(trains), counts, num_threads);
+}
+
+// counts[j] = common(a, b, trains[j]), the triplet coincidences of the pair
+//  (a, b) with every neuron of the population; a & b is made once per tile
+//  (the masked query with b as the mask) and counted against all the rows
+template <typename Bits, typename Population>
+void count_common3(Bits const &a, Bits const &b, Population const &trains, std::span<size_t> counts,
+                   unsigned num_threads = 0)
+{
+  count_common_masked(a, b, trains, counts, num_threads);
+}
+
+// counts[j] = common(a, b, trains[thirds[j]]), the same for a list of third
+//  neurons, e.g., the common neighbours of a and b
+template <typename Bits, typename Population>
+void count_common3(Bits const &a, Bits const &b, Population const &trains, std::span<size_t const> thirds,
+                   std::span<size_t> counts, unsigned num_threads = 0)
+{
+  using block_type = std::remove_cv_t<std::remove_reference_t<decltype(*a.data())>>;
+
+  assert(a.size() == b.size());
+  assert(thirds.size() == counts.size());
+
+  auto const rows = population_rows(trains);
+
+  count_one_vs_many<block_type>(masked_query<block_type>{a.data(), b.data()}, a.num_blocks(),
+                                [&rows, thirds](size_t j) { return rows(thirds[j]); }, thirds.size(), counts,
+                                num_threads);
+}
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_POPULATION_HPP
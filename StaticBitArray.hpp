@@ -20,16 +20,16 @@
 #include <vector>
 #include <bit>
 
+#include "BitKernels.hpp"
+#include "MaskKernels.hpp"
+#include "CountPolicy.hpp"
+
 #ifdef __has_include
 # if __has_include(<version>)
 #   include <version>
 # endif
 #endif
 
-#ifdef __cpp_lib_execution
-#include <execution>
-#endif  /* __cpp_lib_execution */
-
 #ifdef __cpp_lib_ranges
 #include <ranges>
 #endif /* __cpp_lib_ranges */
@@ -45,7 +45,7 @@
 
 namespace nlg {
 
-  template<size_t N, typename Block=std::uint64_t>
+  template<size_t N, typename Block=std::uint64_t, typename CountPolicy=count_eager>
   class StaticBitArray
   {
   public:
@@ -69,9 +69,10 @@ namespace nlg {
     using size_type = size_t;
     using buffer_type = Block[num_of_blocks];
     using block_width_type = unsigned short;
+    using count_policy = CountPolicy;
 
   private:
-    size_t m_count{0};
+    CountPolicy m_counter;
 
     buffer_type m_bits;
 
@@ -85,6 +86,33 @@ namespace nlg {
     static Block bit_mask(size_type pos) noexcept
     { return Block(1) << bit_index(pos); }
 
+    // store the blocks which a mask kernel emits, counting them on the way
+    //  when the policy keeps an eager count
+    template <typename Kernel>
+    void store_blocks(Kernel &&kernel)
+    {
+      block_type *const out = m_bits;
+
+      if constexpr (CountPolicy::counts_bulk)
+      {
+        size_t count = 0;
+
+        kernel([out, &count](size_t i, block_type block)
+        {
+          out[i]  = block;
+          count  += std::popcount(block);
+        });
+
+        m_counter.assign(count);
+      }
+      else
+      {
+        kernel([out](size_t i, block_type block) { out[i] = block; });
+
+        m_counter.invalidate(out, num_of_blocks);
+      }
+    }
+
   public:
 
     StaticBitArray()
@@ -132,8 +160,7 @@ namespace nlg {
     {
       assert(pos < num_of_bits);
 
-      m_bits[block_index(pos)] |= bit_mask(pos);
-      m_count++;
+      m_counter.set(m_bits[block_index(pos)], bit_mask(pos));
 
       return *this;
     }
@@ -142,8 +169,7 @@ namespace nlg {
     {
       assert(pos < size());
 
-      m_bits[block_index(pos)] &= ~bit_mask(pos);
-      m_count--;
+      m_counter.clear(m_bits[block_index(pos)], bit_mask(pos));
 
       return *this;
     }
@@ -165,48 +191,98 @@ namespace nlg {
       std::fill(begin(),end(),Block(0));
 #endif /* __cpp_lib_ranges */
 
-      m_count = 0;
+      m_counter.assign(0);
     }
 
+    // the number of set bits as the count policy keeps it, O(1) unless the
+    //  policy is count_none or a count_lazy one is dirty
     [[nodiscard]] size_t count() const noexcept
     {
-      return m_count;
+      return m_counter.count(std::begin(m_bits), num_of_blocks);
     }
 
-    // return the number of set bits
+    // return the number of set bits, counted anew, and resynchronize count(),
+    //  e.g., after writes through the block iterators; the arrays are small
+    //  enough for the serial popcount
     size_t recount()
     {
-#ifdef __cpp_lib_execution
-      std::atomic<size_t> _count = 0;
+      size_t const _count = kernels::popcount(std::begin(m_bits), num_of_blocks);
 
-      std::for_each(std::execution::par_unseq, begin(), end(),
-                    [&](block_type block) { _count += std::popcount(block); });
+      m_counter.assign(_count);
 
       return _count;
-#else
-      size_t _count = 0;
+    }
 
-      std::for_each(begin(), end(),
-                    [&](block_type block) { _count += std::popcount(block); });
+    // return the number of common set bits (intersection of the two bitsets),
+    //  the kernel (AVX-512 VPOPCNTDQ, AVX2 or scalar) is chosen at runtime
+    [[nodiscard]]  size_t common(StaticBitArray const &other,
+                                 kernels::simd_level level = kernels::cpu_simd_level()) const
+    {
+      return kernels::popcount_and(level, std::begin(m_bits), std::begin(other.m_bits), num_of_blocks);
+    }
 
-      return _count;
-#endif /* __cpp_lib_execution */
+    // return |this|, |other|, their common and their differing set bits in
+    //  one pass
+    [[nodiscard]]  kernels::pair_stats pair_stats(StaticBitArray const &other,
+                                                  kernels::simd_level level = kernels::cpu_simd_level()) const
+    {
+      return kernels::popcount_pair(level, std::begin(m_bits), std::begin(other.m_bits), num_of_blocks);
+    }
+
+    // return the number of set bits common to the three (four) bitsets, in
+    //  one pass without the temporary intersection
+    [[nodiscard]]  size_t common(StaticBitArray const &b, StaticBitArray const &c,
+                                 kernels::simd_level level = kernels::cpu_simd_level()) const
+    {
+      return kernels::popcount_and3(level, std::begin(m_bits), std::begin(b.m_bits), std::begin(c.m_bits), num_of_blocks);
     }
 
-    // return the number of common set bits (intersection of the two bitsets)
-    [[nodiscard]]  size_t common(StaticBitArray const &other)
+    [[nodiscard]]  size_t common(StaticBitArray const &b, StaticBitArray const &c, StaticBitArray const &d,
+                                 kernels::simd_level level = kernels::cpu_simd_level()) const
     {
-      size_t _count = 0;
+      return kernels::popcount_and4(level, std::begin(m_bits), std::begin(b.m_bits), std::begin(c.m_bits),
+                                    std::begin(d.m_bits), num_of_blocks);
+    }
 
-      for (block_type const *lp = begin(), *rp = other.begin(), *lend = m_bits.end(); lp < lend; lp++, rp++)
-        _count += std::popcount(*lp & *rp);
+    // return the number of common set bits with the (right) rotate of other by n,
+    //  i.e., common(rotate(other, n)) computed in one pass without the temporary
+    [[nodiscard]] size_t common_rotated(StaticBitArray const &other, size_t n,
+                                        kernels::simd_level level = kernels::cpu_simd_level()) const
+    {
+      if (n >= num_of_bits)
+        n %= num_of_bits;
 
-      return _count;
+      if (n == 0)
+        return common(other, level);
+
+      return kernels::popcount_and_rotated(level, std::begin(m_bits), std::begin(other.m_bits), num_of_bits, n);
+    }
+
+    // (right) rotate in place, without a second buffer
+    NOINLINE void rotate_inplace(size_t n)
+    {
+      if (n >= num_of_bits)
+        n %= num_of_bits;
+
+      if (n == 0)
+        return;
+
+      kernels::rotate_inplace_blocks(std::begin(m_bits), num_of_bits, n);
     }
 
-    // The fast blockwise implementation of (right) rotate
+    // The fast blockwise implementation of (right) rotate. The main body is
+    //  two straight runs of funnel shifts, one load pair, two shifts, one or
+    //  and one store per block, and the blocks at the seam and at the partial
+    //  tail are assembled separately.
     NOINLINE void rotate(StaticBitArray const &other, size_t n)
     {
+      if (&other == this)
+      {
+        rotate_inplace(n);
+
+        return;
+      }
+
       if (n >= num_of_bits)
         n %= num_of_bits;
 
@@ -217,100 +293,63 @@ namespace nlg {
         return;
       }
 
-      size_type start_blk_pos{block_index(num_of_bits - n)};
-      size_type start_bit_pos{bit_index(num_of_bits - n)};
+      if constexpr (num_of_bits % bits_per_block == 0)
+        kernels::rotate_blocks_aligned(kernels::simd_level::scalar, std::begin(m_bits), std::begin(other.m_bits), num_of_blocks, n);
+      else
+        kernels::rotate_blocks(kernels::simd_level::scalar, std::begin(m_bits), std::begin(other.m_bits), num_of_bits, n);
 
-      size_type opos{0};
-      size_type iblk_pos{start_blk_pos};
-      size_type ibit_pos{start_bit_pos};
-      size_type last_bits = num_of_bits % bits_per_block;
+      m_counter = other.m_counter;
+    }
 
-      while (opos < num_blocks())
+    // (right) rotate by a shift known at compile time, the kernel is
+    //  specialized for the size and the shift and has no runtime branches
+    template <size_t Shift>
+    void rotate(StaticBitArray const &other)
+    {
+      constexpr size_t n = Shift % num_of_bits;
+
+      if (&other == this)
       {
-        block_type block{other.m_bits[iblk_pos]};
+        rotate_inplace(n);
 
-        // make block for output
-        block = (ibit_pos >= bits_per_block) ? 0 : block >> ibit_pos;
+        return;
+      }
 
-        if ((start_bit_pos == ibit_pos) && (iblk_pos == num_blocks() - 1))
-          ibit_pos = last_bits == 0 ? ibit_pos : (bits_per_block - (last_bits - ibit_pos));
+      if constexpr (n == 0)
+        *this = other;
+      else
+      {
+        kernels::rotate_blocks_fixed<num_of_bits, n>(std::begin(m_bits), std::begin(other.m_bits));
+        m_counter = other.m_counter;
+      }
+    }
 
-        iblk_pos++;
-        if (iblk_pos == num_blocks())
-          iblk_pos = 0;
+    // the vectorized (AVX2 / AVX-512) blockwise rotate, the instruction set is
+    //  chosen at runtime and the scalar 'rotate' is used when none is available
+    NOINLINE void rotate_simd(StaticBitArray const &other, size_t n,
+                              kernels::simd_level level = kernels::cpu_simd_level())
+    {
+      level = kernels::clamp_simd_level(level);
 
-        if ((iblk_pos == num_blocks() - 1) && (iblk_pos != start_blk_pos))
-        {
-          block_type rblock{other.m_bits[iblk_pos]};
-
-          rblock = (ibit_pos == 0) ? static_cast<block_type>(0) : rblock << (bits_per_block - ibit_pos);
-          block |= rblock;
-
-          if ((last_bits == 0) || (last_bits >= ibit_pos))
-          {
-            m_bits[opos] = block;
-            opos++;
-
-            rblock = other.m_bits[iblk_pos];
-            block = (rblock >> ibit_pos) & ~(~static_cast<block_type>(0) << (last_bits - ibit_pos));
-            ibit_pos = (last_bits == 0) ? ibit_pos : (bits_per_block - (last_bits - ibit_pos));
-
-            if ((ibit_pos == 0) && (last_bits == 0))
-              continue;
-          }
-          else
-          {
-            ibit_pos -= last_bits;
-            // ibit_pos = last_bits + (bits_per_block - ibit_pos);
-          }
-          iblk_pos = 0;
-        }
-
-        if (iblk_pos == start_blk_pos)
-        {
-          block_type rblock{other.m_bits[iblk_pos]};
-
-          rblock = (ibit_pos == 0) ? 0 : rblock << (bits_per_block - ibit_pos);
-
-          if (ibit_pos >= start_bit_pos)
-          {
-            if (last_bits == 0)
-            {
-              block |= rblock;
-            }
-            else
-            {
-              rblock &= (~static_cast<block_type>(0) >> (bits_per_block - last_bits));
-              block |= rblock;
-              block &= ~(~static_cast<block_type>(0) << last_bits);
-            }
-          }
-          else
-          {
-            block |= rblock;
-
-            m_bits[opos] = block;
-            opos++;
-
-            assert(opos == num_blocks() - 1);
-
-            block = other.m_bits[start_blk_pos];
-
-            block >>= ibit_pos;
-            block &= ~(~static_cast<block_type>(0) << last_bits);
-          }
-        }
-        else
-        {
-          block_type rblock{other.m_bits[iblk_pos]};
+      if (level == kernels::simd_level::scalar)
+      {
+        rotate(other, n);
+
+        return;
+      }
+
+      if (n >= num_of_bits)
+        n %= num_of_bits;
 
-          rblock = (ibit_pos == 0) ? 0 : rblock << (bits_per_block - ibit_pos);
-          block |= rblock;
-        }
+      if (n == 0)
+      {
+        *this = other;
 
-        m_bits[opos] = block;
-        opos++;
+        return;
       }
+
+      kernels::rotate_blocks(level, std::begin(m_bits), std::begin(other.m_bits), num_of_bits, n);
+      m_counter = other.m_counter;
     }
 
     // the slow classical elementwise implementation of rotate
@@ -332,92 +371,125 @@ namespace nlg {
           set(i);
     }
 
-    // create the left neighbour bits, i.e., for each '1' bit
-    //  of the operand we set also the dt left bits in result
-    void createLeftNeighbourMask(StaticBitArray const other, int dt)
+    // create the left neighbour bits, i.e., for each '1' bit at position t
+    //  of the operand we set also the bits t+1 .. t+dt in result
+    void createLeftNeighbourMask(StaticBitArray const &other, int dt)
     {
+      // the mask of a window 0 is the source itself, otherwise the kernel
+      //  writes every block
+      if (dt <= 0)
+      {
 #ifdef __cpp_lib_ranges
-      std::ranges::copy(other.begin(), other.end(), begin());
+        std::ranges::copy(other.begin(), other.end(), begin());
 #else
-      std::copy(other.begin(),other.end(),begin());
+        std::copy(other.begin(),other.end(),begin());
 #endif /* __cpp_lib_ranges */
-      if ((dt > 0) && (dt < int(bits_per_block)))
+        m_counter = other.m_counter;
+
+        return;
+      }
+
+      store_blocks([&](auto emit)
       {
-        buffer_type lbits;
+        kernels::dilate_left(other.m_bits, num_of_bits, size_t(dt), emit);
+      });
+    }
 
+    // create the right neighbour bits, i.e., for each '1' bit at position t
+    //  of the operand we set also the bits t-dt .. t-1 in result
+    void createRightNeighbourMask(StaticBitArray const &other, int dt)
+    {
+      if (dt <= 0)
+      {
 #ifdef __cpp_lib_ranges
-        std::ranges::copy(other.begin(), other.end(), std::begin(lbits));
+        std::ranges::copy(other.begin(), other.end(), begin());
 #else
-        std::copy(other.begin(),other.end(),std::begin(lbits));
+        std::copy(other.begin(),other.end(),begin());
 #endif /* __cpp_lib_ranges */
+        m_counter = other.m_counter;
 
-        for (int ir = 0; ir < dt; ir++)
-        {
-          size_type const last = num_blocks() - 1;     // num_blocks() is >= 1
-          block_type *const b = &lbits[0];
-          auto prev = static_cast<block_type>(0);
-          block_type newv;
-
-          for (int i = last; i >= 0; --i)
-          {
-            newv = (b[i] << 1) | (prev >> (bits_per_block - 1));
-            prev = b[i];
-            b[i] = newv;
-          }
-
-          for (size_type i = 0; i <= last; ++i)
-          {
-            m_bits[i] |= b[i];
-          }
-        }
-
-        m_count = recount();
+        return;
       }
+
+      store_blocks([&](auto emit)
+      {
+        kernels::dilate_right(other.m_bits, num_of_bits, size_t(dt), emit);
+      });
     }
 
-    // create the right neighbour bits, i.e., for each '1' bit
-    //  of the operand we set also the dt right bits in result
-    void createRightNeighbourMask(StaticBitArray const other, int dt)
+    // create the circular left neighbour bits, the bits t+1 .. t+dt are taken
+    //  modulo size(), as the rotate does; dt may exceed size()
+    void createCircularLeftNeighbourMask(StaticBitArray const &other, int dt)
     {
+      if (dt <= 0)
+      {
 #ifdef __cpp_lib_ranges
-      std::ranges::copy(other.begin(), other.end(), begin());
+        std::ranges::copy(other.begin(), other.end(), begin());
 #else
-      std::copy(other.begin(),other.end(),begin());
+        std::copy(other.begin(),other.end(),begin());
 #endif /* __cpp_lib_ranges */
+        m_counter = other.m_counter;
 
-      // distance must be less than the half of the size
-      if ((dt > 0) && (dt < int(bits_per_block)))
+        return;
+      }
+
+      store_blocks([&](auto emit)
       {
-        buffer_type rbits;
+        kernels::dilate_left_circular(other.m_bits, num_of_bits, size_t(dt), emit);
+      });
+    }
 
+    // create the circular right neighbour bits, the bits t-dt .. t-1 are taken
+    //  modulo size()
+    void createCircularRightNeighbourMask(StaticBitArray const &other, int dt)
+    {
+      if (dt <= 0)
+      {
 #ifdef __cpp_lib_ranges
-        std::ranges::copy(other.begin(), other.end(), std::begin(rbits));
+        std::ranges::copy(other.begin(), other.end(), begin());
 #else
-        std::copy(other.begin(),other.end(),std::begin(rbits));
+        std::copy(other.begin(),other.end(),begin());
 #endif /* __cpp_lib_ranges */
+        m_counter = other.m_counter;
 
-        for (int ir = 0; ir < dt; ir++)
-        {
-          size_type const last = num_blocks() - 1;     // num_blocks() is >= 1
-          block_type *const b = &rbits[0];
-          auto prev = static_cast<block_type>(0);
-          block_type newv;
-
-          for (size_type i = 0; i <= last; ++i)
-          {
-            newv = (b[i] >> 1) | (prev << (bits_per_block - 1));
-            prev = b[i];
-            b[i] = newv;
-          }
-
-          for (size_type i = 0; i <= last; ++i)
-          {
-            m_bits[i] |= b[i];
-          }
-        }
-
-        m_count = recount();
+        return;
       }
+
+      store_blocks([&](auto emit)
+      {
+        kernels::dilate_right_circular(other.m_bits, num_of_bits, size_t(dt), emit);
+      });
+    }
+
+    // create the left lag window bits, i.e., for each '1' bit at position t
+    //  of the operand we set the bits t+dt_min .. t+dt_max in result
+    void createLeftLagMask(StaticBitArray const &other, int dt_min, int dt_max)
+    {
+      assert( (0 <= dt_min) && (dt_min <= dt_max) );
+
+      buffer_type source;    // the shifted source is read behind the output
+
+      std::copy(std::begin(other.m_bits), std::end(other.m_bits), std::begin(source));
+
+      store_blocks([&](auto emit)
+      {
+        kernels::dilate_left_lag(source, num_of_bits, size_t(dt_min), size_t(dt_max), emit);
+      });
+    }
+
+    // create the right lag window bits, the bits t-dt_max .. t-dt_min
+    void createRightLagMask(StaticBitArray const &other, int dt_min, int dt_max)
+    {
+      assert( (0 <= dt_min) && (dt_min <= dt_max) );
+
+      buffer_type source;
+
+      std::copy(std::begin(other.m_bits), std::end(other.m_bits), std::begin(source));
+
+      store_blocks([&](auto emit)
+      {
+        kernels::dilate_right_lag(source, num_of_bits, size_t(dt_min), size_t(dt_max), emit);
+      });
     }
 
     bool operator==(StaticBitArray const &other) const noexcept
@@ -429,6 +501,11 @@ namespace nlg {
       return true;
     }
 
+    [[nodiscard]] block_type const *data() const noexcept
+    {
+      return std::begin(m_bits);
+    }
+
     auto begin()
     {
       return std::begin(m_bits);
@@ -15,6 +15,9 @@
 #include <bitset>
 #include <random>
 #include <cstring>
+#include <algorithm>
+#include <vector>
+#include <bit>
 
 #include "BitArray.hpp"
 
@@ -91,6 +94,639 @@ void TestBitArrayFastRotate(int num_tests)
   }
 }
 
+// the rotates of trains of one and two blocks, which take the small
+//  kernel, for every size and every shift
+void TestSmallRotate()
+{
+  std::cout << "Testing BitArray.hpp small rotate" << std::endl;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  auto test = [&gen]<typename block_type>(block_type)
+  {
+    constexpr int bpb = nlg::kernels::bits_of<block_type>;
+
+    for (int num_bits=1; num_bits <= 2 * bpb; num_bits++)
+    {
+      nlg::BitArray<block_type>     bitarr(num_bits);
+      std::uniform_int_distribution bitdistribution(0,num_bits-1);
+
+      for (int j=0; j < num_bits / 2 + 1; j++)
+        bitarr.set(bitdistribution(gen));
+
+      for (int j=0; j < 2 * num_bits; j++)
+      {
+        nlg::BitArray<block_type> bitarr_r1(num_bits);
+        nlg::BitArray<block_type> bitarr_r2(num_bits);
+
+        bitarr_r1.rotate(bitarr,j);
+        bitarr_r2.rotateRight(bitarr,j);
+
+        if (bitarr_r1 != bitarr_r2)
+        {
+          std::cout << "small rotate, block bits " << bpb << ", size " << num_bits << ", shift " << j << std::endl;
+
+          break;
+        }
+      }
+    }
+  };
+
+  test(uint64_t{});
+  test(uint32_t{});
+  test(uint8_t{});
+}
+
+void TestBitArraySimdRotate(int num_tests)
+{
+  std::cout << "Testing BitArray.hpp SIMD rotate" << std::endl;
+
+  using block_type = uint64_t;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(100,1500);
+
+  for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+  {
+    for (int i=0; i < num_tests; i++)
+    {
+      // every fourth array has a size multiple of the block size
+      int   num_bits{(i % 4 == 0) ? 64 * (distribution(gen) / 64) : distribution(gen)};
+
+      nlg::BitArray<block_type>     bitarr(num_bits);
+      std::uniform_int_distribution bitdistribution(0,num_bits-1);
+      uint32_t                      num_ones = static_cast<uint32_t>(distribution(gen));
+
+      for (uint32_t j=0; j < num_ones; j++)
+        bitarr.set(bitdistribution(gen));
+
+      for (int j=0; j < num_bits; j++)
+      {
+        nlg::BitArray<block_type> bitarr_r1(num_bits);
+        nlg::BitArray<block_type> bitarr_r2(num_bits);
+
+        bitarr_r1.rotate_simd(bitarr,j,level);
+        bitarr_r2.rotateRight(bitarr,j);
+
+        if (bitarr_r1 != bitarr_r2)
+        {
+          std::cout << "simd level " << int(level) << ", shift " << j << std::endl;
+
+          print(bitarr, "input");
+
+          print(bitarr_r1,"simd rotate");
+
+          print(bitarr_r2,"element rotate");
+
+          break;
+        }
+      }
+    }
+  }
+}
+
+void TestCommonRotated(int num_tests)
+{
+  std::cout << "Testing BitArray.hpp common_rotated" << std::endl;
+
+  using block_type = uint64_t;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(100,1500);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int   num_bits{(i % 4 == 0) ? 64 * (distribution(gen) / 64) : distribution(gen)};
+
+    nlg::BitArray<block_type>     bitarr_a(num_bits);
+    nlg::BitArray<block_type>     bitarr_b(num_bits);
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+    uint32_t                      num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+    {
+      bitarr_a.set(bitdistribution(gen));
+      bitarr_b.set(bitdistribution(gen));
+    }
+
+    for (int j=0; j < num_bits; j++)
+    {
+      nlg::BitArray<block_type> bitarr_r(num_bits);
+
+      bitarr_r.rotateRight(bitarr_b,j);
+
+      size_t expected{bitarr_a.common(bitarr_r)};
+      bool   failed{false};
+
+      for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+      {
+        size_t fused{bitarr_a.common_rotated(bitarr_b,j,level)};
+
+        if (fused != expected)
+        {
+          std::cout << "common_rotated, level " << int(level) << ", shift " << j << ": " << fused << " != " << expected << std::endl;
+
+          failed = true;
+        }
+      }
+
+      if (failed)
+      {
+        print(bitarr_a, "input a");
+
+        print(bitarr_b, "input b");
+
+        break;
+      }
+    }
+  }
+}
+
+void TestRotateInplace(int num_tests)
+{
+  std::cout << "Testing BitArray.hpp rotate_inplace" << std::endl;
+
+  using block_type = uint64_t;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(1,1500);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int   num_bits{(i % 4 == 0) ? 64 * (distribution(gen) / 64 + 1) : distribution(gen)};
+
+    nlg::BitArray<block_type>     bitarr(num_bits);
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+    uint32_t                      num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+      bitarr.set(bitdistribution(gen));
+
+    for (int j=0; j < num_bits; j++)
+    {
+      nlg::BitArray<block_type> bitarr_r1{bitarr};
+      nlg::BitArray<block_type> bitarr_r2(num_bits);
+
+      nlg::BitArray<block_type> bitarr_r3{bitarr};
+
+      bitarr_r1.rotate_inplace(j);
+      bitarr_r2.rotateRight(bitarr,j);
+      bitarr_r3.rotate(bitarr_r3,j);    // rotate onto itself goes in place
+
+      if ( (bitarr_r1 != bitarr_r2) || (bitarr_r3 != bitarr_r2) )
+      {
+        std::cout << "rotate_inplace, shift " << j << std::endl;
+
+        print(bitarr, "input");
+
+        print(bitarr_r1,"in place rotate");
+
+        print(bitarr_r2,"element rotate");
+
+        break;
+      }
+    }
+  }
+}
+
+// elementwise right rotate of the segment [lo, lo+len) of other by n into result
+template <typename T>
+void rotateSegmentRight(nlg::BitArray<T> &result, nlg::BitArray<T> const &other, size_t lo, size_t len, size_t n)
+{
+  for (size_t i=0; i < len; i++)
+  {
+    if (result.at(lo + i))
+      result.clear(lo + i);
+
+    if (other.at(lo + (i + len - n % len) % len))
+      result.set(lo + i);
+  }
+}
+
+void TestRotateSegments(int num_tests)
+{
+  std::cout << "Testing BitArray.hpp rotate_segments & rotate_trials" << std::endl;
+
+  using block_type = uint64_t;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(100,5000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int   num_bits{distribution(gen)};
+
+    nlg::BitArray<block_type>     bitarr(num_bits);
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+    uint32_t                      num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+      bitarr.set(bitdistribution(gen));
+
+    // segments with random bounds, every other test uses block aligned bounds
+    std::vector<size_t> bounds{0};
+
+    while (bounds.back() < size_t(num_bits))
+    {
+      size_t len = std::uniform_int_distribution(1,600)(gen);
+
+      if (i % 2 == 0)
+        len = 64 * (len / 64 + 1);
+
+      bounds.push_back(std::min(bounds.back() + len, size_t(num_bits)));
+    }
+
+    std::vector<size_t> shifts(bounds.size() - 1);
+
+    for (auto &shift : shifts)
+      shift = bitdistribution(gen);
+
+    nlg::BitArray<block_type> bitarr_r1{bitarr};
+    nlg::BitArray<block_type> bitarr_r2{bitarr};
+
+    nlg::BitArray<block_type>::workspace_type workspace;
+
+    // every other test brings its own workspace
+    if (i % 2 == 0)
+      bitarr_r1.rotate_segments(bounds, shifts);
+    else
+      bitarr_r1.rotate_segments(bounds, shifts, workspace);
+    for (size_t k=0; k < shifts.size(); k++)
+      rotateSegmentRight(bitarr_r2, bitarr, bounds[k], bounds[k+1] - bounds[k], shifts[k]);
+
+    if (bitarr_r1 != bitarr_r2)
+    {
+      std::cout << "rotate_segments, size " << num_bits << ", segments " << shifts.size() << std::endl;
+
+      print(bitarr, "input");
+
+      print(bitarr_r1,"segment rotate");
+
+      print(bitarr_r2,"element rotate");
+
+      break;
+    }
+
+    // fixed length trials, the last one may be shorter
+    size_t              trial_len = std::uniform_int_distribution(1,700)(gen);
+    std::vector<size_t> trial_shifts((num_bits + trial_len - 1) / trial_len);
+
+    for (auto &shift : trial_shifts)
+      shift = bitdistribution(gen);
+
+    nlg::BitArray<block_type> bitarr_t1{bitarr};
+    nlg::BitArray<block_type> bitarr_t2{bitarr};
+
+    bitarr_t1.rotate_trials(trial_len, trial_shifts);
+    for (size_t k=0; k < trial_shifts.size(); k++)
+      rotateSegmentRight(bitarr_t2, bitarr, k * trial_len, std::min(trial_len, num_bits - k * trial_len), trial_shifts[k]);
+
+    if (bitarr_t1 != bitarr_t2)
+    {
+      std::cout << "rotate_trials, size " << num_bits << ", trial length " << trial_len << std::endl;
+
+      print(bitarr, "input");
+
+      print(bitarr_t1,"trial rotate");
+
+      print(bitarr_t2,"element rotate");
+
+      break;
+    }
+  }
+}
+
+// elementwise reference masks, the bits t .. t+dt (left) and t-dt .. t (right)
+//  of every '1' bit t of other
+template <typename T>
+void leftNeighbourMask(nlg::BitArray<T> &result, nlg::BitArray<T> const &other, size_t dt)
+{
+  result.reset();
+  for (size_t t=0; t < other.size(); t++)
+    if (other.at(t))
+      for (size_t k=t; k <= std::min(t + dt, other.size() - 1); k++)
+        result.set(k);
+}
+
+template <typename T>
+void rightNeighbourMask(nlg::BitArray<T> &result, nlg::BitArray<T> const &other, size_t dt)
+{
+  result.reset();
+  for (size_t t=0; t < other.size(); t++)
+    if (other.at(t))
+      for (size_t k=(t > dt ? t - dt : 0); k <= t; k++)
+        result.set(k);
+}
+
+template <typename T>
+void circularNeighbourMask(nlg::BitArray<T> &result, nlg::BitArray<T> const &other, size_t dt, bool left)
+{
+  size_t const num_bits = other.size();
+
+  result.reset();
+  for (size_t t=0; t < num_bits; t++)
+    if (other.at(t))
+      for (size_t k=0; k <= std::min(dt, num_bits - 1); k++)
+        if (size_t pos = left ? (t + k) % num_bits : (t + num_bits - k) % num_bits; !result.at(pos))
+          result.set(pos);
+}
+
+template <typename T>
+void lagMask(nlg::BitArray<T> &result, nlg::BitArray<T> const &other, size_t dt_min, size_t dt_max, bool left)
+{
+  result.reset();
+  for (size_t t=0; t < other.size(); t++)
+    if (other.at(t))
+      for (size_t k=dt_min; k <= dt_max; k++)
+        if (size_t pos = left ? t + k : t - k; (left ? pos < other.size() : k <= t) && !result.at(pos))
+          result.set(pos);
+}
+
+void TestNeighbourMasks(int num_tests)
+{
+  std::cout << "Testing BitArray.hpp left, right & circular neighbour masks" << std::endl;
+
+  using block_type = uint64_t;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(1,1500);
+  std::uniform_int_distribution dtdistribution(1,63);
+  std::uniform_int_distribution widedtdistribution(64,700);  // windows wider than a block
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int   num_bits{distribution(gen)};
+    int   dt{i % 2 == 0 ? dtdistribution(gen) : widedtdistribution(gen)};
+
+    nlg::BitArray<block_type>     bitarr(num_bits);
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+    uint32_t                      num_ones = static_cast<uint32_t>(distribution(gen)) / (1 + i % 20);
+
+    // every fifth train is sparse enough for the runs of the mask builders
+    if (i % 5 == 4)
+      num_ones = i % 3;
+
+    for (uint32_t j=0; j < num_ones; j++)
+      bitarr.set(bitdistribution(gen));
+
+    nlg::BitArray<block_type> mask(num_bits);
+    nlg::BitArray<block_type> expected(num_bits);
+
+    mask.createLeftNeighbourMask(bitarr, dt);
+    leftNeighbourMask(expected, bitarr, dt);
+
+    if ( (mask != expected) || (mask.count() != expected.recount()) )
+    {
+      std::cout << "left neighbour mask, size " << num_bits << ", dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(mask, "mask");
+      print(expected, "expected");
+    }
+
+    // the mask takes the size of the source, the old bits must not leak
+    nlg::BitArray<block_type> resized(num_bits + 100);
+
+    for (uint32_t t=0; t < resized.size(); t++)
+      resized.set(t);
+
+    resized.createLeftNeighbourMask(bitarr, dt);
+
+    if ( (resized != expected) || (resized.count() != expected.recount()) )
+      std::cout << "left neighbour mask of another size, size " << num_bits << ", dt " << dt << std::endl;
+
+    mask.createRightNeighbourMask(bitarr, dt);
+    rightNeighbourMask(expected, bitarr, dt);
+
+    if ( (mask != expected) || (mask.count() != expected.recount()) )
+    {
+      std::cout << "right neighbour mask, size " << num_bits << ", dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(mask, "mask");
+      print(expected, "expected");
+    }
+
+    // the sparse kernels, from the bits and from the spike positions
+    std::vector<uint32_t> spikes;
+
+    for (uint32_t t=0; t < uint32_t(num_bits); t++)
+      if (bitarr.at(t))
+        spikes.push_back(t);
+
+    for (bool left : {true, false})
+    {
+      if (left)
+        leftNeighbourMask(expected, bitarr, dt);
+      else
+        rightNeighbourMask(expected, bitarr, dt);
+
+      std::vector<block_type> blocks(bitarr.num_blocks(), ~block_type(0));
+      size_t const            count = nlg::kernels::sparse_mask(blocks.data(), bitarr.data(), num_bits, dt, left);
+
+      if ( !std::equal(blocks.begin(), blocks.end(), expected.data()) || (count != expected.recount()) )
+        std::cout << "sparse mask, size " << num_bits << ", dt " << dt << ", left " << left << std::endl;
+
+      if (left)
+        mask.createLeftNeighbourMask(std::span<uint32_t const>(spikes), dt);
+      else
+        mask.createRightNeighbourMask(std::span<uint32_t const>(spikes), dt);
+
+      if ( (mask != expected) || (mask.count() != expected.recount()) )
+        std::cout << "mask from spikes, size " << num_bits << ", dt " << dt << ", left " << left << std::endl;
+    }
+
+    size_t const dt_min = std::uniform_int_distribution<size_t>(0,dt)(gen);
+
+    mask.createLeftLagMask(bitarr, int(dt_min), dt);
+    lagMask(expected, bitarr, dt_min, dt, true);
+
+    if ( (mask != expected) || (mask.count() != expected.count()) )
+      std::cout << "left lag mask, size " << num_bits << ", dt " << dt_min << ".." << dt << std::endl;
+
+    mask = bitarr;
+    mask.createLeftLagMask(mask, int(dt_min), dt);
+
+    if (mask != expected)
+      std::cout << "left lag mask in place, size " << num_bits << ", dt " << dt_min << ".." << dt << std::endl;
+
+    mask.createRightLagMask(bitarr, int(dt_min), dt);
+    lagMask(expected, bitarr, dt_min, dt, false);
+
+    if ( (mask != expected) || (mask.count() != expected.count()) )
+      std::cout << "right lag mask, size " << num_bits << ", dt " << dt_min << ".." << dt << std::endl;
+
+    rightNeighbourMask(expected, bitarr, dt);
+
+    // the source may be the mask itself
+    mask = bitarr;
+    mask.createRightNeighbourMask(mask, dt);
+
+    if (mask != expected)
+      std::cout << "right neighbour mask in place, size " << num_bits << ", dt " << dt << std::endl;
+
+    mask.createCircularLeftNeighbourMask(bitarr, dt);
+    circularNeighbourMask(expected, bitarr, dt, true);
+
+    if ( (mask != expected) || (mask.count() != expected.count()) )
+    {
+      std::cout << "circular left neighbour mask, size " << num_bits << ", dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(mask, "mask");
+      print(expected, "expected");
+    }
+
+    mask.createCircularRightNeighbourMask(bitarr, dt);
+    circularNeighbourMask(expected, bitarr, dt, false);
+
+    if ( (mask != expected) || (mask.count() != expected.count()) )
+    {
+      std::cout << "circular right neighbour mask, size " << num_bits << ", dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(mask, "mask");
+      print(expected, "expected");
+    }
+  }
+}
+
+// the popcount kernels of every level and the serial and parallel recount
+//  against one popcount per block
+void TestRecount(int num_tests)
+{
+  using block_type = uint64_t;
+
+  std::cout << "Testing popcount and recount" << std::endl;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution<block_type> blockdistribution;
+  std::uniform_int_distribution             distribution(0,3000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    std::vector<block_type> blocks(distribution(gen));
+
+    for (auto &block : blocks)
+      block = blockdistribution(gen) & blockdistribution(gen);
+
+    size_t const expected = nlg::kernels::popcount_scalar(blocks.data(), blocks.size());
+
+    for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+      if (nlg::kernels::popcount(level, blocks.data(), blocks.size()) != expected)
+        std::cout << "popcount, level " << int(level) << ", " << blocks.size() << " blocks" << std::endl;
+
+    if (nlg::kernels::popcount_harley_seal(blocks.data(), blocks.size()) != expected)
+      std::cout << "harley-seal popcount, " << blocks.size() << " blocks" << std::endl;
+  }
+
+  // three chunks of the parallel recount and a tail
+  size_t const              num_bits = 3 * nlg::BitArray<block_type>::recount_grain * 64 + 77;
+  nlg::BitArray<block_type> bitarr(num_bits);
+  size_t                    expected = 0;
+
+  for (uint32_t pos=0; pos < num_bits; pos += 1 + pos % 13)
+  {
+    bitarr.set(pos);
+    expected++;
+  }
+
+  if ( (bitarr.recount(4) != expected) || (bitarr.recount(1) != expected) || (bitarr.count() != expected) )
+    std::cout << "recount, " << num_bits << " bits" << std::endl;
+}
+
+// common() of two, three and four arrays and pair_stats() at every simd
+//  level against one popcount per block
+void TestCommon(int num_tests)
+{
+  using block_type = uint64_t;
+
+  std::cout << "Testing common" << std::endl;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(1,200000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int                           num_bits{distribution(gen)};
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+    nlg::BitArray<block_type>     bitarr_a(num_bits);
+    nlg::BitArray<block_type>     bitarr_b(num_bits);
+    nlg::BitArray<block_type>     bitarr_c(num_bits);
+    nlg::BitArray<block_type>     bitarr_d(num_bits);
+
+    for (int j=0; j < num_bits / 4; j++)
+    {
+      bitarr_a.set(bitdistribution(gen));
+      bitarr_b.set(bitdistribution(gen));
+      bitarr_c.set(bitdistribution(gen));
+      bitarr_c.set(bitdistribution(gen));
+      bitarr_d.set(bitdistribution(gen));
+      bitarr_d.set(bitdistribution(gen));
+    }
+
+    size_t expected{nlg::kernels::popcount_and_scalar(bitarr_a.data(), bitarr_b.data(), bitarr_a.num_blocks())};
+    size_t expected3{0};
+    size_t expected4{0};
+
+    // the statistics of a and c, each counted on its own from the blocks
+    size_t ones_a{0};
+    size_t ones_c{0};
+    size_t common_ac{0};
+    size_t differ_ac{0};
+
+    for (size_t k=0; k < bitarr_a.num_blocks(); k++)
+    {
+      block_type const abc = bitarr_a.data()[k] & bitarr_b.data()[k] & bitarr_c.data()[k];
+
+      expected3 += std::popcount(abc);
+      expected4 += std::popcount(static_cast<block_type>(abc & bitarr_d.data()[k]));
+
+      ones_a    += std::popcount(bitarr_a.data()[k]);
+      ones_c    += std::popcount(bitarr_c.data()[k]);
+      common_ac += std::popcount(static_cast<block_type>(bitarr_a.data()[k] & bitarr_c.data()[k]));
+      differ_ac += std::popcount(static_cast<block_type>(bitarr_a.data()[k] ^ bitarr_c.data()[k]));
+    }
+
+    for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+    {
+      if (bitarr_a.common(bitarr_b, level) != expected)
+        std::cout << "common, level " << int(level) << ", size " << num_bits << ": "
+                  << bitarr_a.common(bitarr_b, level) << " != " << expected << std::endl;
+
+      if (bitarr_a.common(bitarr_b, bitarr_c, level) != expected3)
+        std::cout << "common of three, level " << int(level) << ", size " << num_bits << ": "
+                  << bitarr_a.common(bitarr_b, bitarr_c, level) << " != " << expected3 << std::endl;
+
+      if (bitarr_a.common(bitarr_b, bitarr_c, bitarr_d, level) != expected4)
+        std::cout << "common of four, level " << int(level) << ", size " << num_bits << ": "
+                  << bitarr_a.common(bitarr_b, bitarr_c, bitarr_d, level) << " != " << expected4 << std::endl;
+
+      auto const stats = bitarr_a.pair_stats(bitarr_c, level);
+
+      if ( (stats.ones_a != ones_a) || (stats.ones_b != ones_c) || (stats.common != common_ac) || (stats.differ != differ_ac) )
+        std::cout << "pair_stats, level " << int(level) << ", size " << num_bits << ": "
+                  << stats.ones_a << " " << stats.ones_b << " " << stats.common << " " << stats.differ << " != "
+                  << ones_a << " " << ones_c << " " << common_ac << " " << differ_ac << std::endl;
+    }
+  }
+}
+
 void TestMaskCreation()
 {
   using block_type = uint64_t;
@@ -159,6 +795,14 @@ int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
     num_tests = std::stoi(argv[1]);
 
   TestBitArrayFastRotate(num_tests);
+  TestSmallRotate();
+  TestBitArraySimdRotate(num_tests / 10);
+  TestCommonRotated(num_tests / 10);
+  TestRotateInplace(num_tests / 10);
+  TestRotateSegments(num_tests);
+  TestNeighbourMasks(num_tests);
+  TestRecount(num_tests / 10);
+  TestCommon(num_tests / 10);
   TestMaskCreation();
 
   return 0;
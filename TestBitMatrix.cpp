@@ -0,0 +1,102 @@
+/**
+ * @file TestBitMatrix.cpp
+ *
+ * @brief test case for BitMatrix.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+
+#include "BitArray.hpp"
+#include "BitMatrix.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+nlg::BitArray<block_type> make_bitarray(int num_bits, int num_ones)
+{
+  nlg::BitArray<block_type>     bitarr(num_bits);
+  std::uniform_int_distribution bitdistribution(0,num_bits-1);
+
+  for (int j=0; j < num_ones; j++)
+    bitarr.set(bitdistribution(gen));
+
+  return bitarr;
+}
+
+// row r of the matrix as a bit array
+nlg::BitArray<block_type> row_bitarray(nlg::BitMatrix<block_type> const &matrix, size_t r)
+{
+  return nlg::BitArray<block_type>(matrix.size(), matrix.row(r), matrix.row(r) + matrix.num_blocks());
+}
+
+void TestRotateBatch(int num_tests)
+{
+  std::cout << "Testing BitMatrix.hpp rotate_batch" << std::endl;
+
+  std::uniform_int_distribution distribution(1,1500);
+
+  for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+  {
+    for (int i=0; i < num_tests; i++)
+    {
+      // every fourth train is longer than one source tile of the batch kernel
+      int  num_bits{(i % 4 == 0) ? 100 * distribution(gen) : distribution(gen)};
+      auto bitarr = make_bitarray(num_bits, distribution(gen));
+
+      std::uniform_int_distribution shiftdistribution(0,2*num_bits);
+      std::vector<size_t>           shifts(1 + i % 37);
+
+      for (auto &shift : shifts)
+        shift = shiftdistribution(gen);
+      shifts[0] = 0;
+
+      nlg::BitMatrix<block_type> surrogates(shifts.size(), num_bits);
+
+      surrogates.rotate_batch(bitarr, shifts, level);
+
+      if (reinterpret_cast<uintptr_t>(surrogates.data()) % nlg::cache_line_size != 0)
+        std::cout << "rotate_batch, matrix is not aligned to the cache line" << std::endl;
+
+      for (size_t k=0; k < shifts.size(); k++)
+      {
+        nlg::BitArray<block_type> bitarr_r(num_bits);
+
+        bitarr_r.rotateRight(bitarr, shifts[k]);
+
+        if (row_bitarray(surrogates, k) != bitarr_r)
+        {
+          std::cout << "rotate_batch, simd level " << int(level) << ", size " << num_bits
+                    << ", row " << k << ", shift " << shifts[k] << std::endl;
+
+          break;
+        }
+
+        for (size_t b=surrogates.num_blocks(); b < surrogates.stride(); b++)
+          if (surrogates.row(k)[b] != 0)
+            std::cout << "rotate_batch, padding block " << b << " of row " << k << " is not zero" << std::endl;
+      }
+    }
+  }
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 100;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  TestRotateBatch(num_tests);
+
+  return 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * @file TestCoincidence.cpp
+ *
+ * @brief test case for Coincidence.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+
+#include "BitArray.hpp"
+#include "StaticBitArray.hpp"
+#include "Coincidence.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+nlg::BitArray<block_type> make_bitarray(int num_bits, int num_ones)
+{
+  nlg::BitArray<block_type>     bitarr(num_bits);
+  std::uniform_int_distribution bitdistribution(0,num_bits-1);
+
+  for (int j=0; j < num_ones; j++)
+    bitarr.set(bitdistribution(gen));
+
+  return bitarr;
+}
+
+void TestFusedCounters(int num_tests)
+{
+  std::cout << "Testing Coincidence.hpp count_left_coincidences & count_right_coincidences" << std::endl;
+
+  std::uniform_int_distribution distribution(1,3000);
+  std::uniform_int_distribution dtdistribution(0,300);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    // every fourth train is long enough for several chunks of the counters
+    int  num_bits{(i % 4 == 3) ? 20 * distribution(gen) : distribution(gen)};
+    int  dt{dtdistribution(gen)};
+    auto a = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+    auto b = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+
+    nlg::BitArray<block_type> mask(num_bits);
+
+    // dt 0 is the plain common()
+    if (dt > 0)
+      mask.createLeftNeighbourMask(b, dt);
+    else
+      mask = b;
+
+    if (size_t left = nlg::count_left_coincidences(a, b, dt); left != a.common(mask))
+      std::cout << "left coincidences, size " << num_bits << ", dt " << dt
+                << ": " << left << " != " << a.common(mask) << std::endl;
+
+    if (dt > 0)
+      mask.createRightNeighbourMask(b, dt);
+
+    if (size_t right = nlg::count_right_coincidences(a, b, dt); right != a.common(mask))
+      std::cout << "right coincidences, size " << num_bits << ", dt " << dt
+                << ": " << right << " != " << a.common(mask) << std::endl;
+  }
+}
+
+void TestCircularCounters(int num_tests)
+{
+  std::cout << "Testing Coincidence.hpp circular counters" << std::endl;
+
+  std::uniform_int_distribution distribution(1,3000);
+  std::uniform_int_distribution dtdistribution(1,300);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    // every fourth train is long enough for several chunks of the counters
+    int  num_bits{(i % 4 == 3) ? 20 * distribution(gen) : distribution(gen)};
+    int  dt{dtdistribution(gen)};
+    auto a = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+    auto b = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+
+    nlg::BitArray<block_type> mask(num_bits);
+
+    mask.createCircularLeftNeighbourMask(b, dt);
+    size_t const left = nlg::count_circular_left_coincidences(a, b, dt);
+
+    if (left != a.common(mask))
+      std::cout << "circular left coincidences, size " << num_bits << ", dt " << dt
+                << ": " << left << " != " << a.common(mask) << std::endl;
+
+    mask.createCircularRightNeighbourMask(b, dt);
+    size_t const right = nlg::count_circular_right_coincidences(a, b, dt);
+
+    if (right != a.common(mask))
+      std::cout << "circular right coincidences, size " << num_bits << ", dt " << dt
+                << ": " << right << " != " << a.common(mask) << std::endl;
+
+    // there is no seam, rotating both trains keeps the counts
+    size_t const              shift = std::uniform_int_distribution(0,num_bits-1)(gen);
+    nlg::BitArray<block_type> a_r(num_bits);
+    nlg::BitArray<block_type> b_r(num_bits);
+
+    a_r.rotate(a, shift);
+    b_r.rotate(b, shift);
+
+    if ( (nlg::count_circular_left_coincidences(a_r, b_r, dt) != left) ||
+         (nlg::count_circular_right_coincidences(a_r, b_r, dt) != right) )
+      std::cout << "circular coincidences of rotated trains, size " << num_bits << ", dt " << dt
+                << ", shift " << shift << std::endl;
+  }
+}
+
+void TestLagCounters(int num_tests)
+{
+  std::cout << "Testing Coincidence.hpp lag window counters" << std::endl;
+
+  std::uniform_int_distribution distribution(1,3000);
+  std::uniform_int_distribution dtdistribution(0,300);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    // every fourth train is long enough for several chunks of the counters
+    int  num_bits{(i % 4 == 3) ? 20 * distribution(gen) : distribution(gen)};
+    int  dt_max{dtdistribution(gen)};
+    int  dt_min{std::uniform_int_distribution(0,dt_max)(gen)};
+    auto a = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+    auto b = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+
+    nlg::BitArray<block_type> mask(num_bits);
+
+    mask.createLeftLagMask(b, dt_min, dt_max);
+    if (size_t left = nlg::count_left_lag_coincidences(a, b, dt_min, dt_max); left != a.common(mask))
+      std::cout << "left lag coincidences, size " << num_bits << ", dt " << dt_min << ".." << dt_max
+                << ": " << left << " != " << a.common(mask) << std::endl;
+
+    mask.createRightLagMask(b, dt_min, dt_max);
+    if (size_t right = nlg::count_right_lag_coincidences(a, b, dt_min, dt_max); right != a.common(mask))
+      std::cout << "right lag coincidences, size " << num_bits << ", dt " << dt_min << ".." << dt_max
+                << ": " << right << " != " << a.common(mask) << std::endl;
+
+    // the window 0 .. dt is the neighbour mask
+    if (nlg::count_left_lag_coincidences(a, b, 0, dt_max) != nlg::count_left_coincidences(a, b, dt_max))
+      std::cout << "left lag coincidences from 0, size " << num_bits << ", dt " << dt_max << std::endl;
+  }
+}
+
+void TestSweep(int num_tests)
+{
+  std::cout << "Testing Coincidence.hpp sweep_coincidences" << std::endl;
+
+  std::uniform_int_distribution distribution(1,3000);
+  std::uniform_int_distribution dtdistribution(0,120);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int    num_bits{distribution(gen)};
+    size_t dt_max{size_t(dtdistribution(gen))};
+    auto   a = make_bitarray(num_bits, distribution(gen) / (1 + i % 10));
+    auto   b = make_bitarray(num_bits, distribution(gen) / (1 + i % 50));
+
+    auto left      = nlg::sweep_coincidences(a, b, dt_max, nlg::window_side::left);
+    auto right     = nlg::sweep_coincidences(a, b, dt_max, nlg::window_side::right);
+    auto symmetric = nlg::sweep_coincidences(a, b, dt_max, nlg::window_side::symmetric);
+
+    if ( (left.size() != dt_max + 1) || (right.size() != dt_max + 1) || (symmetric.size() != dt_max + 1) )
+    {
+      std::cout << "sweep, size " << num_bits << ", dt_max " << dt_max << ": wrong length" << std::endl;
+      continue;
+    }
+
+    nlg::BitArray<block_type> left_mask(num_bits);
+    nlg::BitArray<block_type> right_mask(num_bits);
+
+    for (size_t dt=0; dt <= dt_max; dt++)
+    {
+      size_t const expected_left  = nlg::count_left_coincidences(a, b, dt);
+      size_t const expected_right = nlg::count_right_coincidences(a, b, dt);
+
+      // the symmetric window is the union of the two masks
+      left_mask.createLeftNeighbourMask(b, int(dt));
+      right_mask.createRightNeighbourMask(b, int(dt));
+
+      size_t expected_symmetric = 0;
+
+      for (size_t k=0; k < a.num_blocks(); k++)
+        expected_symmetric += std::popcount(a.data()[k] & (left_mask.data()[k] | right_mask.data()[k]));
+
+      if ( (left[dt] != expected_left) || (right[dt] != expected_right) || (symmetric[dt] != expected_symmetric) )
+        std::cout << "sweep, size " << num_bits << ", dt " << dt
+                  << ": " << left[dt] << "/" << right[dt] << "/" << symmetric[dt] << " != "
+                  << expected_left << "/" << expected_right << "/" << expected_symmetric << std::endl;
+    }
+  }
+}
+
+template <size_t N>
+void TestStaticFusedCounters(int num_tests)
+{
+  std::cout << "Testing Coincidence.hpp StaticBitArray<" << N << "> counters" << std::endl;
+
+  std::uniform_int_distribution distribution(0,int(N)-1);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    nlg::StaticBitArray<N,block_type> a;
+    nlg::StaticBitArray<N,block_type> b;
+    nlg::StaticBitArray<N,block_type> mask;
+    int                               dt{1 + distribution(gen) / 4};
+
+    for (int j=0; j < int(N) / 8; j++)
+    {
+      a.set(distribution(gen));
+      b.set(distribution(gen));
+    }
+
+    mask.createLeftNeighbourMask(b, dt);
+    if (nlg::count_left_coincidences(a, b, dt) != a.common(mask))
+      std::cout << "left coincidences, dt " << dt << std::endl;
+
+    mask.createRightNeighbourMask(b, dt);
+    if (nlg::count_right_coincidences(a, b, dt) != a.common(mask))
+      std::cout << "right coincidences, dt " << dt << std::endl;
+  }
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 1000;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  TestFusedCounters(num_tests);
+  TestCircularCounters(num_tests);
+  TestLagCounters(num_tests);
+  TestSweep(num_tests / 10);
+  TestStaticFusedCounters<1230>(num_tests / 10);
+  TestStaticFusedCounters<40>(num_tests / 10);
+
+  return 0;
+}
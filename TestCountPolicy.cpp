@@ -0,0 +1,217 @@
+/**
+ * @file TestCountPolicy.cpp
+ *
+ * @brief test case for CountPolicy.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <vector>
+
+#include "BitArray.hpp"
+#include "StaticBitArray.hpp"
+#include "CountPolicy.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+template <typename Bits>
+size_t ones(Bits const &bits)
+{
+  return nlg::kernels::popcount_scalar(bits.data(), bits.num_blocks());
+}
+
+int num_failures = 0;         // main returns non-zero when a check fails
+
+template <typename Bits>
+void check(Bits const &bits, char const *policy, char const *op)
+{
+  if (bits.count() != ones(bits))
+  {
+    std::cout << policy << ", count after " << op << ": " << bits.count() << " instead of " << ones(bits) << std::endl;
+
+    num_failures++;
+  }
+}
+
+// every write of BitArray followed by a check of count(); set and clear
+//  hit bits which are already set (clear) as well
+template <typename Policy>
+void TestBitArrayCount(int num_tests, char const *policy)
+{
+  using bits_type = nlg::BitArray<block_type,std::allocator<block_type>,Policy>;
+
+  std::uniform_int_distribution distribution(2,3000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int const                     num_bits{distribution(gen)};
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+    bits_type                     a(num_bits);
+    bits_type                     b(num_bits);
+
+    for (int j=0; j < num_bits / 8 + 1; j++)
+    {
+      uint32_t const pos = bitdistribution(gen);
+
+      a.set(pos);
+      a.set(pos);
+      b.set(bitdistribution(gen));
+    }
+    check(a, policy, "set");
+
+    for (int j=0; j < num_bits / 16 + 1; j++)
+    {
+      uint32_t const pos = bitdistribution(gen);
+
+      a.clear(pos);
+      a.clear(pos);
+    }
+    check(a, policy, "clear");
+
+    size_t const n = bitdistribution(gen);
+
+    b.rotate(a, n);
+    check(b, policy, "rotate");
+
+    b.rotate_simd(a, n + 1);
+    check(b, policy, "rotate_simd");
+
+    b.rotate_inplace(n);
+    check(b, policy, "rotate_inplace");
+
+    size_t const bounds[] = {0, size_t(num_bits) / 2, size_t(num_bits)};
+    size_t const shifts[] = {n, n + 7};
+
+    b.rotate_segments(bounds, shifts);
+    check(b, policy, "rotate_segments");
+
+    int const dt = bitdistribution(gen) % 200;
+
+    b.createLeftNeighbourMask(a, dt);
+    check(b, policy, "createLeftNeighbourMask");
+
+    b.createRightNeighbourMask(a, dt);
+    check(b, policy, "createRightNeighbourMask");
+
+    b.createCircularLeftNeighbourMask(a, dt);
+    check(b, policy, "createCircularLeftNeighbourMask");
+
+    b.createCircularRightNeighbourMask(b, dt);
+    check(b, policy, "createCircularRightNeighbourMask");
+
+    b.createLeftLagMask(a, dt / 2, dt);
+    check(b, policy, "createLeftLagMask");
+
+    b.createRightLagMask(b, dt / 2, dt);
+    check(b, policy, "createRightLagMask");
+
+    std::vector<uint32_t> spikes;
+
+    for (uint32_t pos=0; pos < uint32_t(num_bits); pos++)
+      if (a.at(pos))
+        spikes.push_back(pos);
+
+    b.createLeftNeighbourMask(spikes, dt);
+    check(b, policy, "createLeftNeighbourMask(spikes)");
+
+    bits_type c(num_bits, a.begin(), a.end());
+
+    check(c, policy, "construction from blocks");
+
+    c = b;
+    check(c, policy, "assignment");
+
+    std::fill(c.begin(), c.end(), ~block_type(0));
+    c.clear(0);
+    c.recount();
+    check(c, policy, "recount");
+
+    c.reset();
+    check(c, policy, "reset");
+  }
+}
+
+template <size_t N, typename Policy>
+void TestStaticBitArrayCount(int num_tests, char const *policy)
+{
+  using bits_type = nlg::StaticBitArray<N,block_type,Policy>;
+
+  std::uniform_int_distribution bitdistribution(0,int(N)-1);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    bits_type a;
+    bits_type b;
+
+    for (size_t j=0; j < N / 8 + 1; j++)
+    {
+      uint32_t const pos = bitdistribution(gen);
+
+      a.set(pos);
+      a.set(pos);
+      a.clear(bitdistribution(gen));
+      b.set(bitdistribution(gen));
+    }
+    check(a, policy, "static set and clear");
+
+    size_t const n = bitdistribution(gen);
+
+    b.rotate(a, n);
+    check(b, policy, "static rotate");
+
+    b.template rotate<7>(a);
+    check(b, policy, "static rotate<7>");
+
+    b.rotate_simd(a, n);
+    check(b, policy, "static rotate_simd");
+
+    b.rotateRight(a, n);
+    check(b, policy, "static rotateRight");
+
+    int const dt = bitdistribution(gen) % 100;
+
+    b.createLeftNeighbourMask(a, dt);
+    check(b, policy, "static createLeftNeighbourMask");
+
+    b.createCircularRightNeighbourMask(a, dt);
+    check(b, policy, "static createCircularRightNeighbourMask");
+
+    b.createLeftLagMask(a, dt / 2, dt);
+    check(b, policy, "static createLeftLagMask");
+
+    b.reset();
+    check(b, policy, "static reset");
+  }
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 1000;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  std::cout << "Testing CountPolicy.hpp" << std::endl;
+
+  TestBitArrayCount<nlg::count_none>(num_tests, "count_none");
+  TestBitArrayCount<nlg::count_eager>(num_tests, "count_eager");
+  TestBitArrayCount<nlg::count_lazy>(num_tests, "count_lazy");
+
+  TestStaticBitArrayCount<631,nlg::count_none>(num_tests, "count_none");
+  TestStaticBitArrayCount<631,nlg::count_eager>(num_tests, "count_eager");
+  TestStaticBitArrayCount<1280,nlg::count_lazy>(num_tests, "count_lazy");
+  TestStaticBitArrayCount<40,nlg::count_eager>(num_tests, "count_eager");
+
+  return (num_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file TestCrossCorrelation.cpp
+ *
+ * @brief test case for CrossCorrelation.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+
+#include "CrossCorrelation.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+nlg::BitArray<block_type> make_bitarray(int num_bits, int num_ones)
+{
+  nlg::BitArray<block_type>     bitarr(num_bits);
+  std::uniform_int_distribution bitdistribution(0,num_bits-1);
+
+  for (int j=0; j < num_ones; j++)
+    bitarr.set(bitdistribution(gen));
+
+  return bitarr;
+}
+
+char const *method_name(nlg::profile_method method)
+{
+  switch (method)
+  {
+    case nlg::profile_method::direct: return "direct";
+    case nlg::profile_method::sparse: return "sparse";
+    case nlg::profile_method::fft:    return "fft";
+    default:                          return "automatic";
+  }
+}
+
+void TestProfile(int num_tests)
+{
+  std::cout << "Testing CrossCorrelation.hpp circular_coincidence_profile" << std::endl;
+
+  std::uniform_int_distribution distribution(100,1500);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int  num_bits{distribution(gen)};
+    auto bitarr_a = make_bitarray(num_bits, distribution(gen) / (1 + i % 8));
+    auto bitarr_b = make_bitarray(num_bits, distribution(gen) / (1 + i % 8));
+
+    // the reference profile, one rotate and one common() per shift
+    std::vector<size_t> expected(num_bits);
+
+    for (int s=0; s < num_bits; s++)
+    {
+      nlg::BitArray<block_type> bitarr_r(num_bits);
+
+      bitarr_r.rotateRight(bitarr_b, s);
+      expected[s] = bitarr_a.common(bitarr_r);
+    }
+
+    for (auto method : {nlg::profile_method::automatic, nlg::profile_method::direct,
+                        nlg::profile_method::sparse, nlg::profile_method::fft})
+    {
+      auto profile = nlg::circular_coincidence_profile(bitarr_a, bitarr_b, method);
+
+      if ( (profile.counts != expected) || (profile.zero_lag != profile.counts[0]) )
+      {
+        std::cout << "profile mismatch, method " << method_name(method)
+                  << " (" << method_name(profile.method) << "), size " << num_bits << std::endl;
+
+        break;
+      }
+    }
+  }
+}
+
+void TestLongProfile()
+{
+  std::cout << "Testing CrossCorrelation.hpp long trains (sparse vs fft)" << std::endl;
+
+  int  num_bits = 200003;
+  auto bitarr_a = make_bitarray(num_bits, 2000);
+  auto bitarr_b = make_bitarray(num_bits, 2000);
+
+  auto sparse = nlg::circular_coincidence_profile(bitarr_a, bitarr_b, nlg::profile_method::sparse);
+  auto fft    = nlg::circular_coincidence_profile(bitarr_a, bitarr_b, nlg::profile_method::fft);
+
+  if (sparse.counts != fft.counts)
+    std::cout << "long profile mismatch between sparse and fft" << std::endl;
+
+  for (int s : {0, 1, 777, num_bits - 1})
+    if (sparse.counts[s] != bitarr_a.common_rotated(bitarr_b, s))
+      std::cout << "long profile mismatch at shift " << s << std::endl;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 100;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  TestProfile(num_tests);
+  TestLongProfile();
+
+  return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file TestGram.cpp
+ *
+ * @brief test case for Gram.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+#include "Gram.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+std::vector<nlg::BitArray<block_type>> make_population(int num_trains, int num_bits)
+{
+  std::vector<nlg::BitArray<block_type>> trains;
+  std::uniform_int_distribution          bitdistribution(0,num_bits-1);
+  std::uniform_int_distribution          onesdistribution(0,num_bits/4);
+
+  for (int i=0; i < num_trains; i++)
+  {
+    trains.emplace_back(num_bits);
+
+    for (int j=onesdistribution(gen); j > 0; j--)
+      trains.back().set(bitdistribution(gen));
+  }
+
+  return trains;
+}
+
+// the 4 x 4 micro kernel at every simd level against popcount_and per
+//  pair, the counts cross the 8 blocks of a vector; acc is added to
+void TestPopcountAnd4x4(int num_tests)
+{
+  std::cout << "Testing Gram.hpp popcount_and_4x4" << std::endl;
+
+  std::uniform_int_distribution distribution(1,5000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int  num_bits{distribution(gen)};
+    auto rows = make_population(8, num_bits);
+
+    block_type const *a[4] = {rows[0].data(), rows[1].data(), rows[2].data(), rows[3].data()};
+    block_type const *b[4] = {rows[4].data(), rows[5].data(), rows[6].data(), rows[7].data()};
+    size_t const      count{rows[0].num_blocks()};
+
+    for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+    {
+      size_t acc[16];
+
+      std::fill(std::begin(acc), std::end(acc), size_t(i));
+      nlg::kernels::popcount_and_4x4(level, a, b, count, acc);
+
+      for (int k=0; k < 16; k++)
+        if (acc[k] != size_t(i) + nlg::kernels::popcount_and_scalar(a[k / 4], b[k % 4], count))
+        {
+          std::cout << "popcount_and_4x4, size " << num_bits << ", pair " << k / 4 << " " << k % 4
+                    << ", level " << int(level) << std::endl;
+
+          break;
+        }
+    }
+  }
+}
+
+// the upper triangle against common() per pair, for a vector and a raster;
+//  the numbers of rows cross the tile and the micro block and the sizes
+//  cross the chunk, the lower triangle must stay as it was
+void TestGramMatrix(int num_tests)
+{
+  std::cout << "Testing Gram.hpp gram_matrix" << std::endl;
+
+  std::uniform_int_distribution distribution(1,100000);
+
+  size_t const untouched = ~size_t(0);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int      num_bits{(i % 4 == 0) ? distribution(gen) : distribution(gen) / 100 + 1};
+    int      num_trains{1 + i % 71};
+    unsigned num_threads{1u + unsigned(i % 4)};
+    auto     trains = make_population(num_trains, num_bits);
+
+    nlg::BitMatrix<block_type> raster(num_trains, num_bits);
+
+    for (int k=0; k < num_trains; k++)
+      raster.assign_row(k, trains[k]);
+
+    std::vector<size_t> gram(num_trains * num_trains, untouched);
+    std::vector<size_t> raster_gram(num_trains * num_trains, untouched);
+
+    nlg::gram_matrix(trains, gram, num_threads);
+    nlg::gram_matrix(raster, raster_gram, num_threads);
+
+    for (int r=0; r < num_trains; r++)
+      for (int c=0; c < num_trains; c++)
+      {
+        size_t const expected = (r <= c) ? trains[r].common(trains[c]) : untouched;
+
+        if ( (gram[r * num_trains + c] != expected) || (raster_gram[r * num_trains + c] != expected) )
+        {
+          std::cout << "gram_matrix, size " << num_bits << ", trains " << num_trains << ", pair " << r << " " << c
+                    << ", threads " << num_threads << std::endl;
+
+          r = num_trains;
+          break;
+        }
+      }
+  }
+}
+
+// every measure of the similarity matrix against pair_stats() per pair,
+//  the matrix is symmetric
+void TestSimilarityMatrix(int num_tests)
+{
+  std::cout << "Testing Gram.hpp similarity_matrix" << std::endl;
+
+  std::uniform_int_distribution distribution(1,20000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int      num_bits{distribution(gen)};
+    int      num_trains{1 + i % 37};
+    unsigned num_threads{1u + unsigned(i % 3)};
+    auto     trains  = make_population(num_trains, num_bits);
+    auto     measure = static_cast<nlg::similarity>(i % 3);
+
+    std::vector<size_t> gram(num_trains * num_trains);
+    std::vector<double> out(num_trains * num_trains);
+
+    nlg::similarity_matrix(trains, measure, gram, out, num_threads);
+
+    for (int r=0; r < num_trains; r++)
+      for (int c=0; c < num_trains; c++)
+      {
+        auto const   stats    = trains[r].pair_stats(trains[c]);
+        double const either   = double(stats.common + stats.differ);
+        double const norm     = std::sqrt(double(stats.ones_a) * double(stats.ones_b));
+        double const expected = (measure == nlg::similarity::jaccard) ? ((either == 0) ? 0.0 : double(stats.common) / either) :
+                                (measure == nlg::similarity::hamming) ? double(stats.differ) :
+                                                                        ((norm == 0) ? 0.0 : double(stats.common) / norm);
+
+        if (std::abs(out[r * num_trains + c] - expected) > 1e-12)
+        {
+          std::cout << "similarity_matrix, measure " << int(measure) << ", size " << num_bits << ", pair " << r << " " << c
+                    << ": " << out[r * num_trains + c] << " != " << expected << std::endl;
+
+          r = num_trains;
+          break;
+        }
+      }
+  }
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 100;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  TestPopcountAnd4x4(num_tests);
+  TestGramMatrix(num_tests);
+  TestSimilarityMatrix(num_tests);
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file TestMaskCache.cpp
+ *
+ * @brief test case for MaskCache.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+
+#include "BitArray.hpp"
+#include "MaskCache.hpp"
+#include "Coincidence.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+nlg::BitArray<block_type> make_bitarray(int num_bits, int num_ones)
+{
+  nlg::BitArray<block_type>     bitarr(num_bits);
+  std::uniform_int_distribution bitdistribution(0,num_bits-1);
+
+  for (int j=0; j < num_ones; j++)
+    bitarr.set(bitdistribution(gen));
+
+  return bitarr;
+}
+
+// the mask of the cache against the mask builders of BitArray
+bool same_mask(nlg::MaskCache<block_type> &cache, std::vector<nlg::BitArray<block_type>> const &trains,
+               size_t train, nlg::mask_kind kind, size_t dt)
+{
+  nlg::BitArray<block_type> expected(trains[train].size());
+
+  switch (kind)
+  {
+    case nlg::mask_kind::left:           expected.createLeftNeighbourMask(trains[train], int(dt));           break;
+    case nlg::mask_kind::right:          expected.createRightNeighbourMask(trains[train], int(dt));          break;
+    case nlg::mask_kind::circular_left:  expected.createCircularLeftNeighbourMask(trains[train], int(dt));  break;
+    case nlg::mask_kind::circular_right: expected.createCircularRightNeighbourMask(trains[train], int(dt)); break;
+  }
+
+  block_type const *mask = cache.mask(train, kind, dt);
+
+  return std::equal(expected.data(), expected.data() + expected.num_blocks(), mask);
+}
+
+void TestMaskCache(int num_tests)
+{
+  std::cout << "Testing MaskCache.hpp" << std::endl;
+
+  std::uniform_int_distribution distribution(1,2000);
+
+  auto const kinds = {nlg::mask_kind::left, nlg::mask_kind::right, nlg::mask_kind::circular_left, nlg::mask_kind::circular_right};
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int                                    num_bits{distribution(gen)};
+    std::vector<nlg::BitArray<block_type>> trains;
+
+    for (int k=0; k < 6; k++)
+      trains.push_back(make_bitarray(num_bits, distribution(gen) / 10));
+
+    std::vector<size_t>        dts{1, 20, 100};
+    nlg::MaskCache<block_type> cache(trains, dts);
+
+    for (size_t t=0; t < trains.size(); t++)
+      for (auto kind : kinds)
+        for (size_t dt : dts)
+          if (!same_mask(cache, trains, t, kind, dt))
+            std::cout << "mask cache, size " << num_bits << ", train " << t << ", dt " << dt << std::endl;
+
+    size_t const num_builds = cache.num_builds();
+
+    if (num_builds != trains.size() * kinds.size() * dts.size())
+      std::cout << "mask cache, built " << num_builds << " masks" << std::endl;
+
+    // the second round hits the cache
+    for (size_t t=0; t < trains.size(); t++)
+      if (cache.coincidences(trains[0], t, nlg::mask_kind::left, 20) != nlg::count_left_coincidences(trains[0], trains[t], 20))
+        std::cout << "mask cache coincidences, size " << num_bits << ", train " << t << std::endl;
+
+    if (cache.num_builds() != num_builds)
+      std::cout << "mask cache, rebuilt masks of unchanged trains" << std::endl;
+
+    // every kind of modification invalidates the masks of its train only
+    std::uniform_int_distribution bitdistribution(0,num_bits-1);
+
+    trains[1].set(bitdistribution(gen));
+    trains[2].clear(bitdistribution(gen));
+    trains[3].rotate_inplace(bitdistribution(gen));
+    trains[4] = trains[5];
+
+    for (size_t t=0; t < trains.size(); t++)
+      if (!same_mask(cache, trains, t, nlg::mask_kind::right, 20))
+        std::cout << "mask cache after a modification, size " << num_bits << ", train " << t << std::endl;
+
+    if (cache.num_builds() != num_builds + 4)
+      std::cout << "mask cache, rebuilt " << cache.num_builds() - num_builds << " masks instead of 4" << std::endl;
+  }
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 1000;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  TestMaskCache(num_tests / 10);
+
+  return 0;
+}
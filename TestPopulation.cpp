@@ -0,0 +1,200 @@
+/**
+ * @file TestPopulation.cpp
+ *
+ * @brief test case for Population.hpp
+ *
+ * @ingroup StrictClusteringCoefficient
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#include <iostream>
+#include <random>
+
+#include "Population.hpp"
+
+using block_type = uint64_t;
+
+std::random_device rd;        // Will be used to obtain a seed for the random number engine
+std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+std::vector<nlg::BitArray<block_type>> make_population(int num_trains, int num_bits)
+{
+  std::vector<nlg::BitArray<block_type>> trains;
+  std::uniform_int_distribution          bitdistribution(0,num_bits-1);
+  std::uniform_int_distribution          onesdistribution(0,num_bits/4);
+
+  for (int i=0; i < num_trains; i++)
+  {
+    trains.emplace_back(num_bits);
+
+    for (int j=onesdistribution(gen); j > 0; j--)
+      trains.back().set(bitdistribution(gen));
+  }
+
+  return trains;
+}
+
+nlg::BitMatrix<block_type> make_raster(std::vector<nlg::BitArray<block_type>> const &trains)
+{
+  nlg::BitMatrix<block_type> raster(trains.size(), trains.front().size());
+
+  for (size_t i=0; i < trains.size(); i++)
+    raster.assign_row(i, trains[i]);
+
+  return raster;
+}
+
+void TestRotatePopulation(int num_tests)
+{
+  std::cout << "Testing Population.hpp rotate_population" << std::endl;
+
+  std::uniform_int_distribution distribution(1,1500);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int      num_bits{distribution(gen)};
+    int      num_trains{1 + i % 50};
+    unsigned num_threads{1u + unsigned(i % 5)};
+    auto     trains = make_population(num_trains, num_bits);
+    auto     raster = make_raster(trains);
+
+    std::uniform_int_distribution shiftdistribution(0,2*num_bits);
+    std::vector<size_t>           shifts(num_trains);
+
+    for (auto &shift : shifts)
+      shift = shiftdistribution(gen);
+
+    std::vector<nlg::BitArray<block_type>> out(num_trains, nlg::BitArray<block_type>(num_bits));
+    nlg::BitMatrix<block_type>             raster_out(num_trains, num_bits);
+
+    nlg::rotate_population(trains, shifts, out, num_threads);
+    nlg::rotate_population(raster, shifts, raster_out, num_threads);
+
+    for (int k=0; k < num_trains; k++)
+    {
+      nlg::BitArray<block_type> bitarr_r(num_bits);
+
+      bitarr_r.rotateRight(trains[k], shifts[k]);
+
+      nlg::BitArray<block_type> raster_r(num_bits, raster_out.row(k), raster_out.row(k) + raster_out.num_blocks());
+
+      if ( (out[k] != bitarr_r) || (raster_r != bitarr_r) )
+      {
+        std::cout << "rotate_population, size " << num_bits << ", row " << k
+                  << ", shift " << shifts[k] << ", threads " << num_threads << std::endl;
+
+        break;
+      }
+    }
+  }
+}
+
+// the one vs many counts, plain, rotated and masked, against common() per
+//  train; the sizes cross the tile size
+void TestCountCommon(int num_tests)
+{
+  std::cout << "Testing Population.hpp count_common" << std::endl;
+
+  std::uniform_int_distribution distribution(1,300000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int      num_bits{(i % 4 == 0) ? distribution(gen) : distribution(gen) / 100 + 1};
+    int      num_trains{1 + i % 20};
+    unsigned num_threads{1u + unsigned(i % 3)};
+    auto     trains = make_population(num_trains, num_bits);
+    auto     raster = make_raster(trains);
+    auto     query  = make_population(2, num_bits);
+    size_t   n      = std::uniform_int_distribution<size_t>(0,2*num_bits)(gen);
+
+    nlg::BitArray<block_type> rotated(num_bits);
+    nlg::BitArray<block_type> masked{query[0]};
+
+    rotated.rotateRight(query[0], n);
+
+    for (int k=0; k < num_bits; k++)
+      if (!query[1].at(k))
+        masked.clear(k);
+
+    std::vector<size_t> counts(num_trains);
+    std::vector<size_t> raster_counts(num_trains);
+    std::vector<size_t> rotated_counts(num_trains);
+    std::vector<size_t> masked_counts(num_trains);
+
+    nlg::count_common(query[0], trains, counts, num_threads);
+    nlg::count_common(query[0], raster, raster_counts, num_threads);
+    nlg::count_common_rotated(query[0], n, raster, rotated_counts, num_threads);
+    nlg::count_common_masked(query[0], query[1], trains, masked_counts, num_threads);
+
+    for (int k=0; k < num_trains; k++)
+    {
+      if ( (counts[k] != query[0].common(trains[k])) || (raster_counts[k] != counts[k]) )
+        std::cout << "count_common, size " << num_bits << ", row " << k << ", threads " << num_threads << std::endl;
+
+      if (rotated_counts[k] != rotated.common(trains[k]))
+        std::cout << "count_common_rotated, size " << num_bits << ", row " << k << ", shift " << n << std::endl;
+
+      if (masked_counts[k] != masked.common(trains[k]))
+        std::cout << "count_common_masked, size " << num_bits << ", row " << k << std::endl;
+    }
+  }
+}
+
+// the triplet counts of a pair against every train and against a list of
+//  third neurons, against common() of three arrays
+void TestCountCommon3(int num_tests)
+{
+  std::cout << "Testing Population.hpp count_common3" << std::endl;
+
+  std::uniform_int_distribution distribution(1,300000);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    int      num_bits{(i % 4 == 0) ? distribution(gen) : distribution(gen) / 100 + 1};
+    int      num_trains{1 + i % 20};
+    unsigned num_threads{1u + unsigned(i % 3)};
+    auto     trains = make_population(num_trains, num_bits);
+    auto     raster = make_raster(trains);
+    auto     pair   = make_population(2, num_bits);
+
+    std::uniform_int_distribution<size_t> thirddistribution(0,num_trains-1);
+    std::vector<size_t>                   thirds(1 + i % 7);
+
+    for (auto &third : thirds)
+      third = thirddistribution(gen);
+
+    std::vector<size_t> counts(num_trains);
+    std::vector<size_t> raster_counts(num_trains);
+    std::vector<size_t> third_counts(thirds.size());
+
+    nlg::count_common3(pair[0], pair[1], trains, counts, num_threads);
+    nlg::count_common3(pair[0], pair[1], raster, raster_counts, num_threads);
+    nlg::count_common3(pair[0], pair[1], raster, thirds, third_counts, num_threads);
+
+    for (int k=0; k < num_trains; k++)
+      if ( (counts[k] != pair[0].common(pair[1], trains[k])) || (raster_counts[k] != counts[k]) )
+        std::cout << "count_common3, size " << num_bits << ", row " << k << ", threads " << num_threads << std::endl;
+
+    for (size_t k=0; k < thirds.size(); k++)
+      if (third_counts[k] != pair[0].common(pair[1], trains[thirds[k]]))
+        std::cout << "count_common3 of thirds, size " << num_bits << ", third " << thirds[k] << std::endl;
+  }
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
+{
+  int  num_tests = 100;
+
+  if (argc == 2)
+    num_tests = std::stoi(argv[1]);
+
+  TestRotatePopulation(num_tests);
+  TestCountCommon(num_tests);
+  TestCountCommon3(num_tests);
+
+  return 0;
+}
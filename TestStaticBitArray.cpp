@@ -15,6 +15,7 @@
 #include <bitset>
 #include <random>
 #include <cstring>
+#include <bit>
 
 #include "StaticBitArray.hpp"
 
@@ -90,6 +91,424 @@ void TestBitArrayFastRotate(int num_tests)
   }
 }
 
+template <size_t N>
+void TestBitArraySimdRotate(int num_tests)
+{
+  std::cout << "Testing StaticBitArray<" << N << "> SIMD rotate" << std::endl;
+
+  using block_type = uint64_t;
+  constexpr size_t  num_bits = N;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(0,int(num_bits-1));
+
+  for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+  {
+    for (int i=0; i < num_tests; i++)
+    {
+      nlg::StaticBitArray<num_bits,block_type> bitarr;
+      auto                                     num_ones = static_cast<uint32_t>(distribution(gen));
+
+      for (uint32_t j=0; j < num_ones; j++)
+        bitarr.set(distribution(gen));
+
+      for (size_t j=0; j < num_bits; j++)
+      {
+        nlg::StaticBitArray<num_bits,block_type> bitarr_r1;
+        nlg::StaticBitArray<num_bits,block_type> bitarr_r2;
+
+        bitarr_r1.rotate_simd(bitarr,j,level);
+        bitarr_r2.rotateRight(bitarr,j);
+
+        if (bitarr_r1 != bitarr_r2)
+        {
+          std::cout << "simd level " << int(level) << ", shift " << j << std::endl;
+
+          print(bitarr, "input");
+
+          print(bitarr_r1,"simd rotate");
+
+          print(bitarr_r2,"element rotate");
+
+          break;
+        }
+      }
+    }
+  }
+}
+
+template <size_t N>
+void TestCommonRotated(int num_tests)
+{
+  std::cout << "Testing StaticBitArray<" << N << "> common_rotated" << std::endl;
+
+  using block_type = uint64_t;
+  constexpr size_t  num_bits = N;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(0,int(num_bits-1));
+
+  for (int i=0; i < num_tests; i++)
+  {
+    nlg::StaticBitArray<num_bits,block_type> bitarr_a;
+    nlg::StaticBitArray<num_bits,block_type> bitarr_b;
+    auto                                     num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+    {
+      bitarr_a.set(distribution(gen));
+      bitarr_b.set(distribution(gen));
+    }
+
+    for (size_t j=0; j < num_bits; j++)
+    {
+      nlg::StaticBitArray<num_bits,block_type> bitarr_r;
+
+      bitarr_r.rotateRight(bitarr_b,j);
+
+      size_t expected{bitarr_a.common(bitarr_r)};
+      bool   failed{false};
+
+      for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+      {
+        size_t fused{bitarr_a.common_rotated(bitarr_b,j,level)};
+
+        if (fused != expected)
+        {
+          std::cout << "common_rotated, level " << int(level) << ", shift " << j << ": " << fused << " != " << expected << std::endl;
+
+          failed = true;
+        }
+      }
+
+      if (failed)
+      {
+        print(bitarr_a, "input a");
+
+        print(bitarr_b, "input b");
+
+        break;
+      }
+    }
+  }
+}
+
+// common() of every simd level against one popcount per block
+template <size_t N>
+void TestCommon(int num_tests)
+{
+  std::cout << "Testing StaticBitArray<" << N << "> common" << std::endl;
+
+  using block_type = uint64_t;
+  constexpr size_t  num_bits = N;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(0,int(num_bits-1));
+
+  for (int i=0; i < num_tests; i++)
+  {
+    nlg::StaticBitArray<num_bits,block_type> bitarr_a;
+    nlg::StaticBitArray<num_bits,block_type> bitarr_b;
+    nlg::StaticBitArray<num_bits,block_type> bitarr_c;
+    nlg::StaticBitArray<num_bits,block_type> bitarr_d;
+    auto                                     num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+    {
+      bitarr_a.set(distribution(gen));
+      bitarr_b.set(distribution(gen));
+      bitarr_c.set(distribution(gen));
+      bitarr_d.set(distribution(gen));
+    }
+
+    size_t expected{nlg::kernels::popcount_and_scalar(bitarr_a.data(), bitarr_b.data(), bitarr_a.num_blocks())};
+    size_t expected3{0};
+    size_t expected4{0};
+
+    for (size_t k=0; k < num_bits; k++)
+    {
+      bool const abc = bitarr_a.at(k) && bitarr_b.at(k) && bitarr_c.at(k);
+
+      expected3 += abc;
+      expected4 += abc && bitarr_d.at(k);
+    }
+
+    // the statistics of a and b, each counted on its own from the blocks
+    size_t ones_a{0};
+    size_t ones_b{0};
+    size_t common_ab{0};
+    size_t differ_ab{0};
+
+    for (size_t k=0; k < bitarr_a.num_blocks(); k++)
+    {
+      ones_a    += std::popcount(bitarr_a.data()[k]);
+      ones_b    += std::popcount(bitarr_b.data()[k]);
+      common_ab += std::popcount(static_cast<block_type>(bitarr_a.data()[k] & bitarr_b.data()[k]));
+      differ_ab += std::popcount(static_cast<block_type>(bitarr_a.data()[k] ^ bitarr_b.data()[k]));
+    }
+
+    for (auto level : {nlg::kernels::simd_level::scalar, nlg::kernels::simd_level::avx2, nlg::kernels::simd_level::avx512})
+    {
+      if (bitarr_a.common(bitarr_b, level) != expected)
+        std::cout << "common, level " << int(level) << ": " << bitarr_a.common(bitarr_b, level) << " != " << expected << std::endl;
+
+      if (bitarr_a.common(bitarr_b, bitarr_c, level) != expected3)
+        std::cout << "common of three, level " << int(level) << ": " << bitarr_a.common(bitarr_b, bitarr_c, level)
+                  << " != " << expected3 << std::endl;
+
+      if (bitarr_a.common(bitarr_b, bitarr_c, bitarr_d, level) != expected4)
+        std::cout << "common of four, level " << int(level) << ": " << bitarr_a.common(bitarr_b, bitarr_c, bitarr_d, level)
+                  << " != " << expected4 << std::endl;
+
+      auto const stats = bitarr_a.pair_stats(bitarr_b, level);
+
+      if ( (stats.ones_a != ones_a) || (stats.ones_b != ones_b) || (stats.common != common_ab) || (stats.differ != differ_ab) )
+        std::cout << "pair_stats, level " << int(level) << ": "
+                  << stats.ones_a << " " << stats.ones_b << " " << stats.common << " " << stats.differ << " != "
+                  << ones_a << " " << ones_b << " " << common_ab << " " << differ_ab << std::endl;
+    }
+  }
+}
+
+template <size_t N>
+void TestRotateInplace(int num_tests)
+{
+  std::cout << "Testing StaticBitArray<" << N << "> rotate_inplace" << std::endl;
+
+  using block_type = uint64_t;
+  constexpr size_t  num_bits = N;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(0,int(num_bits-1));
+
+  for (int i=0; i < num_tests; i++)
+  {
+    nlg::StaticBitArray<num_bits,block_type> bitarr;
+    auto                                     num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+      bitarr.set(distribution(gen));
+
+    for (size_t j=0; j < num_bits; j++)
+    {
+      nlg::StaticBitArray<num_bits,block_type> bitarr_r1{bitarr};
+      nlg::StaticBitArray<num_bits,block_type> bitarr_r2;
+
+      bitarr_r1.rotate_inplace(j);
+      bitarr_r2.rotateRight(bitarr,j);
+
+      if (bitarr_r1 != bitarr_r2)
+      {
+        std::cout << "rotate_inplace, shift " << j << std::endl;
+
+        print(bitarr, "input");
+
+        print(bitarr_r1,"in place rotate");
+
+        print(bitarr_r2,"element rotate");
+
+        break;
+      }
+    }
+  }
+}
+
+template <size_t N, size_t... Shifts>
+void TestFixedRotate(int num_tests)
+{
+  std::cout << "Testing StaticBitArray<" << N << "> rotate<Shift>" << std::endl;
+
+  using block_type = uint64_t;
+  constexpr size_t  num_bits = N;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(0,int(num_bits-1));
+
+  for (int i=0; i < num_tests; i++)
+  {
+    nlg::StaticBitArray<num_bits,block_type> bitarr;
+    auto                                     num_ones = static_cast<uint32_t>(distribution(gen));
+
+    for (uint32_t j=0; j < num_ones; j++)
+      bitarr.set(distribution(gen));
+
+    auto check = [&]<size_t Shift>()
+    {
+      nlg::StaticBitArray<num_bits,block_type> bitarr_r1;
+      nlg::StaticBitArray<num_bits,block_type> bitarr_r2;
+
+      bitarr_r1.template rotate<Shift>(bitarr);
+      bitarr_r2.rotateRight(bitarr,Shift);
+
+      if (bitarr_r1 != bitarr_r2)
+      {
+        std::cout << "rotate<" << Shift << ">" << std::endl;
+
+        print(bitarr, "input");
+
+        print(bitarr_r1,"fixed rotate");
+
+        print(bitarr_r2,"element rotate");
+      }
+    };
+
+    (check.template operator()<Shifts>(), ...);
+  }
+}
+
+template <size_t N>
+void TestNeighbourMasks(int num_tests)
+{
+  std::cout << "Testing StaticBitArray<" << N << "> left, right & circular neighbour masks" << std::endl;
+
+  using block_type = uint64_t;
+
+  std::random_device rd;        // Will be used to obtain a seed for the random number engine
+  std::mt19937       gen(rd()); // Standard mersenne_twister_engine seeded with rd()
+
+  std::uniform_int_distribution distribution(1,int(N));
+  std::uniform_int_distribution dtdistribution(1,63);
+  std::uniform_int_distribution widedtdistribution(64,700);  // windows wider than a block
+  std::uniform_int_distribution bitdistribution(0,int(N)-1);
+
+  for (int i=0; i < num_tests; i++)
+  {
+    size_t dt{size_t(i % 2 == 0 ? dtdistribution(gen) : widedtdistribution(gen))};
+
+    nlg::StaticBitArray<N,block_type> bitarr;
+    uint32_t                          num_ones = static_cast<uint32_t>(distribution(gen)) / (1 + i % 20);
+
+    for (uint32_t j=0; j < num_ones; j++)
+      bitarr.set(bitdistribution(gen));
+
+    nlg::StaticBitArray<N,block_type> left;
+    nlg::StaticBitArray<N,block_type> right;
+    nlg::StaticBitArray<N,block_type> expected_left;
+    nlg::StaticBitArray<N,block_type> expected_right;
+    nlg::StaticBitArray<N,block_type> circular_left;
+    nlg::StaticBitArray<N,block_type> circular_right;
+    nlg::StaticBitArray<N,block_type> expected_circular_left;
+    nlg::StaticBitArray<N,block_type> expected_circular_right;
+
+    left.createLeftNeighbourMask(bitarr, int(dt));
+    right.createRightNeighbourMask(bitarr, int(dt));
+    circular_left.createCircularLeftNeighbourMask(bitarr, int(dt));
+    circular_right.createCircularRightNeighbourMask(bitarr, int(dt));
+
+    for (size_t t=0; t < N; t++)
+    {
+      if (!bitarr.at(t))
+        continue;
+
+      for (size_t k=t; k <= std::min(t + dt, N - 1); k++)
+        expected_left.set(k);
+
+      for (size_t k=(t > dt ? t - dt : 0); k <= t; k++)
+        expected_right.set(k);
+
+      for (size_t k=0; k <= std::min(dt, N - 1); k++)
+      {
+        expected_circular_left.set((t + k) % N);
+        expected_circular_right.set((t + N - k) % N);
+      }
+    }
+
+    // the lag windows dt/2 .. dt, the second one built in place
+    nlg::StaticBitArray<N,block_type> left_lag;
+    nlg::StaticBitArray<N,block_type> right_lag{bitarr};
+    nlg::StaticBitArray<N,block_type> expected_left_lag;
+    nlg::StaticBitArray<N,block_type> expected_right_lag;
+
+    left_lag.createLeftLagMask(bitarr, int(dt / 2), int(dt));
+    right_lag.createRightLagMask(right_lag, int(dt / 2), int(dt));
+
+    for (size_t t=0; t < N; t++)
+      if (bitarr.at(t))
+        for (size_t k=dt / 2; k <= dt; k++)
+        {
+          if (t + k < N)
+            expected_left_lag.set(t + k);
+
+          if (k <= t)
+            expected_right_lag.set(t - k);
+        }
+
+    if ( (left_lag != expected_left_lag) || (left_lag.count() != expected_left_lag.recount()) )
+      std::cout << "left lag mask, dt " << dt / 2 << ".." << dt << std::endl;
+
+    if ( (right_lag != expected_right_lag) || (right_lag.count() != expected_right_lag.recount()) )
+      std::cout << "right lag mask, dt " << dt / 2 << ".." << dt << std::endl;
+
+    if ( (left != expected_left) || (left.count() != expected_left.recount()) )
+    {
+      std::cout << "left neighbour mask, dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(left, "mask");
+      print(expected_left, "expected");
+    }
+
+    if ( (right != expected_right) || (right.count() != expected_right.recount()) )
+    {
+      std::cout << "right neighbour mask, dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(right, "mask");
+      print(expected_right, "expected");
+    }
+
+    if ( (circular_left != expected_circular_left) || (circular_left.count() != expected_circular_left.recount()) )
+    {
+      std::cout << "circular left neighbour mask, dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(circular_left, "mask");
+      print(expected_circular_left, "expected");
+    }
+
+    if ( (circular_right != expected_circular_right) || (circular_right.count() != expected_circular_right.recount()) )
+    {
+      std::cout << "circular right neighbour mask, dt " << dt << std::endl;
+
+      print(bitarr, "input");
+      print(circular_right, "mask");
+      print(expected_circular_right, "expected");
+    }
+
+    // a destination holding another mask must be fully overwritten
+    nlg::StaticBitArray<N,block_type> reused{circular_left};
+    reused.createRightNeighbourMask(bitarr, int(dt));
+
+    if ( (reused != expected_right) || (reused.count() != expected_right.recount()) )
+    {
+      std::cout << "reused right neighbour mask, dt " << dt << std::endl;
+
+      print(reused, "mask");
+      print(expected_right, "expected");
+    }
+
+    reused.createLeftNeighbourMask(bitarr, 0);
+
+    if ( (reused != bitarr) || (reused.count() != bitarr.recount()) )
+    {
+      std::cout << "reused left neighbour mask, dt 0" << std::endl;
+
+      print(reused, "mask");
+      print(bitarr, "expected");
+    }
+  }
+}
+
 template <size_t N>
 void TestMaskCreation()
 {
@@ -160,6 +579,26 @@ int main([[maybe_unused]] int argc, [[maybe_unused]]  char **argv)
     num_tests = std::stoi(argv[1]);
 
   TestBitArrayFastRotate<357>(num_tests);
+  TestBitArrayFastRotate<1280>(num_tests / 10);
+  TestBitArrayFastRotate<100>(num_tests / 10);
+  TestBitArrayFastRotate<40>(num_tests / 10);
+  TestBitArraySimdRotate<1230>(num_tests / 100);
+  TestBitArraySimdRotate<1280>(num_tests / 100);
+  TestCommonRotated<357>(num_tests / 10);
+  TestCommonRotated<1280>(num_tests / 100);
+  TestCommon<40>(num_tests / 10);
+  TestCommon<631>(num_tests / 10);
+  TestCommon<1280>(num_tests / 10);
+  TestRotateInplace<357>(num_tests / 10);
+  TestRotateInplace<40>(num_tests / 10);
+  TestRotateInplace<1280>(num_tests / 100);
+  TestFixedRotate<1230, 0, 1, 17, 63, 64, 65, 615, 1166, 1229, 1230, 1231>(num_tests / 10);
+  TestFixedRotate<1280, 0, 1, 17, 63, 64, 65, 640, 1216, 1279, 1280, 1281>(num_tests / 10);
+  TestFixedRotate<40, 1, 7, 39, 41>(num_tests / 10);
+  TestFixedRotate<64, 1, 7, 63>(num_tests / 10);
+  TestNeighbourMasks<631>(num_tests / 10);
+  TestNeighbourMasks<1280>(num_tests / 10);
+  TestNeighbourMasks<40>(num_tests / 10);
   TestMaskCreation<631>();
 
   return 0;
@@ -0,0 +1,98 @@
+/**
+ * @file Workspace.hpp
+ *
+ * @brief Per thread scratch storage for the mask, rotate and coincidence loops
+ *
+ * @ingroup neurolingo
+ *
+ * A workspace keeps block buffers and bit arrays alive between calls, so
+ * the pair x surrogate loops allocate only while the workspace warms up.
+ * The buffers only grow and a bit array is rebuilt only when it is asked
+ * with another size, so in the steady state nothing is allocated.
+ *
+ * The slots of 'buffer' and 'bits' belong to the caller; the library
+ * borrows its own buffer through 'scratch', e.g., the segment rotates.
+ * 'local()' returns the workspace of the calling thread; a workspace is
+ * never shared between threads.
+ *
+ * @author Christos Tsalidis
+ * Contact: tsalidis@neurolingo.gr
+ * Created on 16/10/2026.
+ *
+ */
+
+#ifndef BITARRAYFASTROTATE_WORKSPACE_HPP
+#define BITARRAYFASTROTATE_WORKSPACE_HPP
+
+#include <cstddef>
+#include <deque>
+
+namespace nlg {
+
+// the deques keep the references of the slots valid while new slots are added
+template <typename Bits>
+class Workspace
+{
+public:
+  using bits_type   = Bits;
+  using buffer_type = typename Bits::buffer_type;
+
+private:
+  buffer_type             m_scratch;
+  std::deque<buffer_type> m_buffers;
+  std::deque<Bits>        m_bits;
+
+public:
+
+  Workspace() = default;
+  Workspace(Workspace const &) = delete;
+
+  Workspace &operator=(Workspace const &) = delete;
+
+  ~Workspace() = default;
+
+  // the workspace of the calling thread
+  static Workspace &local()
+  {
+    thread_local Workspace workspace;
+
+    return workspace;
+  }
+
+  // the buffer of the library kernels, num_blocks blocks of unspecified content
+  buffer_type &scratch(size_t num_blocks)
+  {
+    if (m_scratch.size() < num_blocks)
+      m_scratch.resize(num_blocks);
+
+    return m_scratch;
+  }
+
+  // the buffer of slot, at least num_blocks blocks of unspecified content
+  buffer_type &buffer(size_t slot, size_t num_blocks)
+  {
+    while (m_buffers.size() <= slot)
+      m_buffers.emplace_back();
+
+    if (m_buffers[slot].size() < num_blocks)
+      m_buffers[slot].resize(num_blocks);
+
+    return m_buffers[slot];
+  }
+
+  // the bit array of slot with num_bits bits of unspecified content
+  Bits &bits(size_t slot, size_t num_bits)
+  {
+    while (m_bits.size() <= slot)
+      m_bits.emplace_back(num_bits);
+
+    if (m_bits[slot].size() != num_bits)
+      m_bits[slot] = Bits(num_bits);
+
+    return m_bits[slot];
+  }
+};
+
+}  // namespace nlg
+
+#endif //BITARRAYFASTROTATE_WORKSPACE_HPP